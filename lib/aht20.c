@@ -13,7 +13,7 @@
 bool aht20_init(i2c_inst_t *i2c) {
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
-    sleep_ms(50);  // Aguarda o sensor inicializar
+    sleep_ms(10);  // Tempo do comando de inicialização pelo datasheet; o laço abaixo cobre atrasos
 
     // Verifica status até que o sensor esteja pronto
     uint8_t status;
@@ -69,8 +69,6 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
 void aht20_reset(i2c_inst_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
     i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
-    sleep_ms(20);
-    aht20_init(i2c);
 }
 
 bool aht20_check(i2c_inst_t *i2c) {
@@ -22,7 +22,8 @@ bool aht20_init(i2c_inst_t *i2c);
 // Faz a leitura de temperatura e umidade do AHT20
 bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
 
-// Reseta o sensor AHT20
+// Reseta o sensor AHT20. Não espera: o sensor leva 20 ms para aceitar aht20_init, tempo que a
+// inicialização pode usar com os outros periféricos
 void aht20_reset(i2c_inst_t *i2c);
 
 bool aht20_check(i2c_inst_t *i2c);
@@ -0,0 +1,90 @@
+#include "hardware/pwm.h"
+#include "alarm.h"
+
+// Padrões de bipe (ms): ligado, desligado, ligado, ...
+static const uint16_t padrao_aviso[] = { 100, 900 };
+static const uint16_t padrao_critico[] = { 100, 100, 100, 100, 100, 600 };
+
+alarm_severity_t alarm_check_limits(const alarm_channel_t *channel, float value, float min, float max) {
+    // Em alarme, o limite efetivo fica hysteresis para dentro da faixa
+    float margem = (channel->severity != ALARM_NONE) ? channel->hysteresis : 0.0f;
+    float excesso;
+
+    if (value > max - margem)
+        excesso = value - max;
+    else if (value < min + margem)
+        excesso = min - value;
+    else
+        return ALARM_NONE;
+
+    return (excesso >= channel->critical_margin) ? ALARM_CRITICAL : ALARM_WARNING;
+}
+
+alarm_severity_t alarm_channel_update(alarm_channel_t *channel, alarm_severity_t measured, uint32_t now_ms) {
+    if (measured == channel->severity)
+        return channel->severity;
+
+    uint32_t decorrido = now_ms - channel->changed_ms;
+    bool pode_mudar;
+    if (channel->severity == ALARM_NONE)
+        pode_mudar = decorrido >= channel->min_off_ms;   // Disparar de novo
+    else if (measured > channel->severity)
+        pode_mudar = true;                               // Agravamento é imediato
+    else
+        pode_mudar = decorrido >= channel->min_on_ms;    // Atenuar ou desligar
+
+    if (pode_mudar) {
+        channel->severity = measured;
+        channel->changed_ms = now_ms;
+    }
+    return channel->severity;
+}
+
+// Avança um passo do padrão. O retorno negativo reagenda a partir do disparo anterior, sem acumular atraso
+static int64_t alarm_beeper_callback(alarm_id_t id, void *user_data) {
+    alarm_beeper_t *beeper = (alarm_beeper_t *)user_data;
+
+    beeper->step = (beeper->step + 1) % beeper->pattern_len;
+    pwm_set_gpio_level(beeper->gpio, (beeper->step % 2 == 0) ? beeper->level_on : 0);
+    return -(int64_t)beeper->pattern[beeper->step] * 1000;
+}
+
+void alarm_beeper_init(alarm_beeper_t *beeper, uint gpio, uint16_t level_on) {
+    beeper->gpio = gpio;
+    beeper->level_on = level_on;
+    beeper->alarm_id = 0;
+    beeper->severity = ALARM_NONE;
+    beeper->pattern = NULL;
+    beeper->pattern_len = 0;
+    beeper->step = 0;
+    pwm_set_gpio_level(gpio, 0);
+}
+
+void alarm_beeper_set(alarm_beeper_t *beeper, alarm_severity_t severity) {
+    if (severity == beeper->severity)
+        return;
+
+    if (beeper->alarm_id > 0) {
+        cancel_alarm(beeper->alarm_id);
+        beeper->alarm_id = 0;
+    }
+    beeper->severity = severity;
+
+    if (severity == ALARM_NONE) {
+        pwm_set_gpio_level(beeper->gpio, 0);
+        return;
+    }
+
+    if (severity == ALARM_CRITICAL) {
+        beeper->pattern = padrao_critico;
+        beeper->pattern_len = sizeof(padrao_critico) / sizeof(padrao_critico[0]);
+    } else {
+        beeper->pattern = padrao_aviso;
+        beeper->pattern_len = sizeof(padrao_aviso) / sizeof(padrao_aviso[0]);
+    }
+
+    // Começa ligado; o alarme avança os passos seguintes
+    beeper->step = 0;
+    pwm_set_gpio_level(beeper->gpio, beeper->level_on);
+    beeper->alarm_id = add_alarm_in_ms(beeper->pattern[0], alarm_beeper_callback, beeper, true);
+}
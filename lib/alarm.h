@@ -0,0 +1,59 @@
+#ifndef ALARM_H
+#define ALARM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+
+typedef enum {
+    ALARM_NONE,
+    ALARM_WARNING,   // Fora do limite
+    ALARM_CRITICAL   // Além do limite por mais que critical_margin
+} alarm_severity_t;
+
+/**
+ * Alarme de uma grandeza. A histerese evita que valores próximos do limite liguem e desliguem o
+ * alarme a cada amostra; os tempos mínimos seguram cada estado por um período. Subir de severidade
+ * é imediato; baixar exige min_on_ms no estado atual, e voltar a disparar exige min_off_ms desligado.
+ */
+typedef struct {
+    // Configuração
+    float hysteresis;       // Margem, para dentro do limite, que o valor precisa cruzar para sair do alarme
+    float critical_margin;  // Distância além do limite a partir da qual o alarme é crítico
+    uint32_t min_on_ms;
+    uint32_t min_off_ms;
+
+    // Estado
+    uint8_t severity;       // alarm_severity_t após os tempos mínimos
+    uint32_t changed_ms;    // Instante da última mudança de severidade
+} alarm_channel_t;
+
+#define ALARM_CHANNEL(hysteresis, critical_margin, min_on_ms, min_off_ms) \
+    { (hysteresis), (critical_margin), (min_on_ms), (min_off_ms), ALARM_NONE, 0 }
+
+// Severidade do valor frente aos limites, considerando a histerese a partir do estado atual do canal
+alarm_severity_t alarm_check_limits(const alarm_channel_t *channel, float value, float min, float max);
+
+// Aplica os tempos mínimos à severidade medida e retorna a severidade resultante do canal
+alarm_severity_t alarm_channel_update(alarm_channel_t *channel, alarm_severity_t measured, uint32_t now_ms);
+
+/**
+ * Sequenciador do buzzer: toca o padrão de bipes da severidade atual, alternando o nível PWM do
+ * pino a partir de um alarme de hardware. O laço principal só escolhe a severidade.
+ */
+typedef struct {
+    uint gpio;
+    uint16_t level_on;              // Nível PWM do bipe
+    alarm_id_t alarm_id;
+    volatile uint8_t severity;
+    const uint16_t *pattern;        // Durações em ms, alternando ligado e desligado, repetidas em ciclo
+    uint8_t pattern_len;
+    volatile uint8_t step;
+} alarm_beeper_t;
+
+void alarm_beeper_init(alarm_beeper_t *beeper, uint gpio, uint16_t level_on);
+
+// Troca o padrão tocado. Não faz nada se a severidade não mudou
+void alarm_beeper_set(alarm_beeper_t *beeper, alarm_severity_t severity);
+
+#endif // ALARM_H
@@ -1,3 +1,5 @@
+#include <math.h>
+
 #include "bmp280.h"
 #include "hardware/i2c.h"
 
@@ -18,16 +20,15 @@ void bmp280_init(i2c_inst_t *i2c) {
  //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
+bool bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure) {
     uint8_t buf[6];
     uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    if (i2c_write_blocking(i2c, ADDR, &reg, 1, true) != 1) return false;
+    if (i2c_read_blocking(i2c, ADDR, buf, 6, false) != 6) return false;
 
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
-
-
+    return true;
 }
 
 void bmp280_reset(i2c_inst_t *i2c) {
@@ -102,3 +103,7 @@ void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params)
 
 
 }
+
+double bmp280_altitude(double pressure) {
+    return 44330.0 * (1.0 - pow(pressure / BMP280_SEA_LEVEL_PA, 0.1903));
+}
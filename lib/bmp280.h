@@ -45,6 +45,8 @@
 
 #define NUM_CALIB_PARAMS 24
 
+#define BMP280_SEA_LEVEL_PA 101325.0 // Pressão ao nível do mar usada no cálculo da altitude
+
 struct bmp280_calib_param {
     uint16_t dig_t1;
     int16_t dig_t2;
@@ -63,10 +65,13 @@ struct bmp280_calib_param {
 
 //void bmp280_init(void);
 void bmp280_init(i2c_inst_t *i2c);
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
+bool bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure); // false em erro na I2C
 void bmp280_reset(i2c_inst_t *i2c);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params);
 void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params);
 
+// Altitude estimada (m) a partir da pressão em Pa, pela fórmula barométrica
+double bmp280_altitude(double pressure);
+
 #endif
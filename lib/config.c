@@ -0,0 +1,116 @@
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#include "config.h"
+
+// Último setor da flash, longe do programa
+#define CONFIG_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define CONFIG_MAGIC 0x31474643u   // "CFG1": muda se o formato de config_t mudar
+#define CONFIG_FLASH_TIMEOUT_MS 100
+
+// Registro gravado na flash
+typedef struct {
+    uint32_t magic;
+    config_t config;
+    uint32_t checksum;
+} config_record_t;
+
+static const char *const nomes_canais[CONFIG_NUM_CHANNELS] = { "temp", "hum", "press" };
+
+// Faixa de medição dos sensores (AHT20 e BMP280): limites fora dela nunca disparariam
+static const config_limits_t faixas[CONFIG_NUM_CHANNELS] = {
+    [CONFIG_TEMP]  = { -40.0f, 85.0f },   // °C
+    [CONFIG_HUM]   = { 0.0f, 100.0f },    // %
+    [CONFIG_PRESS] = { 30.0f, 110.0f },   // kPa
+};
+
+const char *config_channel_name(config_channel_t channel) {
+    return nomes_canais[channel];
+}
+
+// Hash FNV-1a do registro, sem o próprio checksum
+static uint32_t config_checksum(const config_record_t *record) {
+    const uint8_t *p = (const uint8_t *)record;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < offsetof(config_record_t, checksum); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static const char *config_validate(const config_t *config) {
+    for (int i = 0; i < CONFIG_NUM_CHANNELS; i++) {
+        const config_limits_t *l = &config->limits[i];
+        if (!isfinite(l->min) || !isfinite(l->max)) return "limite invalido";
+        if (l->min < faixas[i].min || l->max > faixas[i].max) return "limite fora da faixa do sensor";
+        if (l->min >= l->max) return "minimo deve ser menor que o maximo";
+    }
+    return NULL;
+}
+
+void config_init(config_store_t *store, const config_t *defaults) {
+    const config_record_t *gravado = (const config_record_t *)(XIP_BASE + CONFIG_FLASH_OFFSET);
+
+    memset(store, 0, sizeof(*store));
+    store->latch = (seqlatch_t)SEQLATCH_INIT(&store->copies[0], &store->copies[1], sizeof(config_t));
+
+    // Flash apagada, formato antigo ou gravação interrompida: volta aos valores padrão
+    if (gravado->magic == CONFIG_MAGIC && gravado->checksum == config_checksum(gravado)
+        && !config_validate(&gravado->config)) {
+        store->write = gravado->config;
+    } else {
+        store->write = *defaults;
+    }
+    store->saved_version = store->write.version;
+    seqlatch_publish(&store->latch, &store->write);
+}
+
+void config_get(const config_store_t *store, config_t *out) {
+    seqlatch_read(&store->latch, out);
+}
+
+bool config_update(config_store_t *store, const config_t *config, const char **error) {
+    const char *erro = config_validate(config);
+    if (erro) {
+        if (error) *error = erro;
+        return false;
+    }
+
+    uint32_t versao = store->write.version + 1;
+    store->write = *config;
+    store->write.version = versao;
+    seqlatch_publish(&store->latch, &store->write);
+    store->changed_ms = to_ms_since_boot(get_absolute_time());
+    return true;
+}
+
+// Executada com as interrupções desligadas e o XIP parado: nada aqui pode ler da flash
+static void config_flash_write(void *page) {
+    flash_range_erase(CONFIG_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(CONFIG_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+}
+
+void config_save_pending(config_store_t *store, uint32_t now_ms) {
+    config_record_t record;
+    config_get(store, &record.config);
+    if (record.config.version == store->saved_version) return;
+
+    // Alterações em sequência (vários campos ajustados na página) viram uma única gravação
+    if (now_ms - store->changed_ms < CONFIG_SAVE_DELAY_MS) return;
+
+    record.magic = CONFIG_MAGIC;
+    record.checksum = config_checksum(&record);
+
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &record, sizeof(record));
+
+    if (flash_safe_execute(config_flash_write, page, CONFIG_FLASH_TIMEOUT_MS) == PICO_OK) {
+        store->saved_version = record.config.version;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "seqlatch.h"
+
+#define CONFIG_SAVE_DELAY_MS 5000  // Espera sem novas alterações antes de gravar na flash
+
+typedef enum {
+    CONFIG_TEMP,
+    CONFIG_HUM,
+    CONFIG_PRESS,
+    CONFIG_NUM_CHANNELS
+} config_channel_t;
+
+typedef struct {
+    float min;
+    float max;
+} config_limits_t;
+
+// Configuração ativa. Sempre lida e alterada por inteiro
+typedef struct {
+    uint32_t version;                          // Incrementada a cada alteração aceita
+    config_limits_t limits[CONFIG_NUM_CHANNELS];
+} config_t;
+
+/**
+ * Configuração com um único escritor (os handlers HTTP, no contexto do lwIP) e leitores que não
+ * podem ver uma alteração pela metade. Cada alteração é validada e publicada de uma vez por um
+ * seqlatch; a gravação na flash fica para o laço principal, depois que as alterações param.
+ */
+typedef struct {
+    config_t write;                 // Cópia do escritor
+    config_t copies[2];
+    seqlatch_t latch;
+    volatile uint32_t changed_ms;   // Instante da última alteração publicada
+    uint32_t saved_version;         // Versão gravada na flash
+} config_store_t;
+
+// Nome do canal nos parâmetros e no JSON ("temp", "hum", "press")
+const char *config_channel_name(config_channel_t channel);
+
+// Carrega a configuração gravada na flash ou, se não houver uma válida, usa defaults
+void config_init(config_store_t *store, const config_t *defaults);
+
+// Copia a configuração ativa. Pode ser chamada de qualquer contexto
+void config_get(const config_store_t *store, config_t *out);
+
+/**
+ * Valida e publica uma nova configuração (a versão em config é ignorada e substituída pela próxima).
+ * Retorna false, com a causa em *error, sem alterar nada se algum canal tiver min >= max ou um
+ * limite fora da faixa do sensor (temp -40 a 85 °C, hum 0 a 100 %, press 30 a 110 kPa).
+ */
+bool config_update(config_store_t *store, const config_t *config, const char **error);
+
+// Grava a configuração na flash se ela mudou e não há alterações há CONFIG_SAVE_DELAY_MS. Laço principal
+void config_save_pending(config_store_t *store, uint32_t now_ms);
+
+#endif // CONFIG_H
@@ -0,0 +1,73 @@
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "events.h"
+#include "metrics.h"
+
+static const char *const nomes[EVENT_COUNT] = {
+    [EVENT_SAMPLE]  = "amostra",
+    [EVENT_BUTTON]  = "botao",
+    [EVENT_NETWORK] = "rede",
+    [EVENT_USB]     = "usb",
+};
+
+// Um contexto que interrompe outro no meio do incremento pode fazer uma postagem se perder, mas o
+// contador muda de qualquer forma, e é só a mudança que o laço observa
+static volatile uint32_t postados[EVENT_COUNT];
+static uint32_t vistos[EVENT_COUNT];      // Só o laço principal
+static uint32_t despertares = 0;          // Retornos de events_wait com algum evento ou prazo vencido
+static uint64_t dormindo_us = 0;
+static uint32_t dormindo_ms = 0;          // Cópia de 32 bits para o coletor, que pode interromper a escrita
+
+static void events_collect(metrics_writer_t *w, unsigned part) {
+    char labels[24];
+
+    metrics_family(w, "station_events_total", "counter", "Eventos postados para o laco principal");
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        snprintf(labels, sizeof(labels), "evento=\"%s\"", nomes[i]);
+        metrics_uint(w, "station_events_total", labels, postados[i]);
+    }
+    metrics_family(w, "station_wakeups_total", "counter", "Vezes que o laco principal acordou");
+    metrics_uint(w, "station_wakeups_total", NULL, despertares);
+    metrics_family(w, "station_sleep_ms_total", "counter", "Tempo do laco principal dormindo a espera de eventos");
+    metrics_uint(w, "station_sleep_ms_total", NULL, dormindo_ms);
+}
+
+void events_init(void) {
+    metrics_register(events_collect, 1);
+}
+
+void events_post(event_t event) {
+    postados[event]++;
+    __sev(); // Acorda o WFE, mesmo que a postagem caia entre a verificação e o WFE de events_wait
+}
+
+static uint32_t pendentes(void) {
+    uint32_t mascara = 0;
+    for (int i = 0; i < EVENT_COUNT; i++) {
+        uint32_t n = postados[i];
+        if (n != vistos[i]) {
+            vistos[i] = n;
+            mascara |= EVENT_BIT(i);
+        }
+    }
+    return mascara;
+}
+
+uint32_t events_wait(absolute_time_t deadline) {
+    uint32_t mascara = pendentes();
+    uint64_t inicio = time_us_64();
+
+    // O WFE também volta por interrupções que não postam nada (USB, cyw43): confere e dorme de novo
+    while (!mascara && !best_effort_wfe_or_timeout(deadline)) {
+        mascara = pendentes();
+    }
+    if (!mascara) mascara = pendentes();
+
+    dormindo_us += time_us_64() - inicio;
+    dormindo_ms = (uint32_t)(dormindo_us / 1000);
+    despertares++;
+    return mascara;
+}
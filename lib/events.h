@@ -0,0 +1,35 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+/**
+ * Eventos para o laço principal, postados por temporizadores, interrupções de GPIO e pelo lwIP.
+ * Cada evento tem um contador incrementado por quem posta e a cópia do último valor visto pelo laço:
+ * sem fila nem bloqueio, postar nunca espera e vale de qualquer contexto. Postagens repetidas antes
+ * de o laço acordar se juntam em uma só.
+ */
+typedef enum {
+    EVENT_SAMPLE,   // Hora de ler os sensores
+    EVENT_BUTTON,   // Troca de tela pelo botão A
+    EVENT_NETWORK,  // Mudança no enlace ou no IP do Wi-Fi
+    EVENT_USB,      // Caracteres recebidos pela USB
+    EVENT_COUNT
+} event_t;
+
+#define EVENT_BIT(e) (1u << (e))
+
+// Registra o coletor de /metrics com as contagens e o tempo dormindo
+void events_init(void);
+
+void events_post(event_t event);
+
+/**
+ * Retorna os eventos pendentes (EVENT_BIT de cada um), dormindo com WFE até que algum seja postado
+ * ou até deadline. Retorna 0 se o prazo venceu sem eventos. Só o laço principal chama.
+ */
+uint32_t events_wait(absolute_time_t deadline);
+
+#endif // EVENTS_H
@@ -0,0 +1,81 @@
+#include "history.h"
+
+typedef struct {
+    uint16_t tag;         // 16 bits baixos do período gravado: distingue o registro atual de um antigo
+    int16_t temperature;  // Centésimos de °C
+    uint16_t humidity;    // Centésimos de %
+    uint16_t pressure;    // Centésimos de kPa
+} history_record_t;
+
+static history_record_t anel[HISTORY_MAX_RECORDS];
+static bool gravou = false;    // Algum registro no anel: sem isso, tag 0 do anel zerado valeria como período 0
+static uint32_t fim = 0;       // Período seguinte ao último gravado
+
+// Soma das amostras do período em andamento
+static uint32_t periodo_atual = 0;
+static uint32_t soma_n = 0;
+static float soma_temp, soma_umi, soma_press;
+
+static int32_t centesimos(float v, int32_t min, int32_t max) {
+    float c = v * 100.0f;
+    int32_t r = (int32_t)(c < 0 ? c - 0.5f : c + 0.5f);
+    return r < min ? min : r > max ? max : r;
+}
+
+static void gravar(uint32_t periodo) {
+    history_record_t *r = &anel[periodo % HISTORY_MAX_RECORDS];
+    r->tag = (uint16_t)periodo;
+    r->temperature = (int16_t)centesimos(soma_temp / soma_n, INT16_MIN, INT16_MAX);
+    r->humidity = (uint16_t)centesimos(soma_umi / soma_n, 0, UINT16_MAX);
+    r->pressure = (uint16_t)centesimos(soma_press / soma_n, 0, UINT16_MAX);
+    gravou = true;
+    fim = periodo + 1;
+}
+
+void history_add(uint32_t now_ms, float temperature, float humidity, float pressure) {
+    uint32_t periodo = now_ms / 1000 / HISTORY_PERIOD_S;
+    if (soma_n && periodo != periodo_atual) {
+        gravar(periodo_atual);
+        soma_n = 0;
+    }
+    if (!soma_n) {
+        periodo_atual = periodo;
+        soma_temp = soma_umi = soma_press = 0;
+    }
+    soma_temp += temperature;
+    soma_umi += humidity;
+    soma_press += pressure;
+    soma_n++;
+}
+
+uint32_t history_end(void) {
+    return fim;
+}
+
+uint32_t history_first(void) {
+    return fim > HISTORY_MAX_RECORDS ? fim - HISTORY_MAX_RECORDS : 0;
+}
+
+bool history_get(uint32_t period, uint32_t count, history_point_t *out) {
+    uint32_t primeiro = history_first();
+    int32_t temp = 0;
+    uint32_t umi = 0, press = 0, n = 0;
+
+    for (uint32_t p = period; p - period < count && p < fim; p++) {
+        if (p < primeiro) continue;
+        const history_record_t *r = &anel[p % HISTORY_MAX_RECORDS];
+        if (!gravou || r->tag != (uint16_t)p) continue; // Período sem amostras
+        temp += r->temperature;
+        umi += r->humidity;
+        press += r->pressure;
+        n++;
+    }
+    if (!n) return false;
+
+    out->t_s = period * HISTORY_PERIOD_S;
+    out->records = n;
+    out->temperature = temp / 100.0f / n;
+    out->humidity = umi / 100.0f / n;
+    out->pressure = press / 100.0f / n;
+    return true;
+}
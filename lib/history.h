@@ -0,0 +1,34 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HISTORY_PERIOD_S 60        // Cada registro guarda a média das amostras de um minuto
+#define HISTORY_MAX_RECORDS 2880   // 48 h em RAM, 8 bytes por registro
+
+/**
+ * Histórico de longo prazo para /export: médias por período em registros compactos (centésimos de
+ * °C, de % e de kPa), num anel indexado pelo número do período desde o boot. Períodos sem amostras
+ * ficam sem registro. O único escritor é webserver_publish_sample, com o lwIP bloqueado, e os
+ * leitores são os handlers HTTP, então não há outra sincronização.
+ */
+typedef struct {
+    uint32_t t_s;        // Início do intervalo, em segundos desde o boot
+    uint16_t records;    // Registros que entraram na média
+    float temperature;
+    float humidity;
+    float pressure;
+} history_point_t;
+
+// Acumula uma amostra; a média do período é gravada quando chega a primeira amostra do seguinte
+void history_add(uint32_t now_ms, float temperature, float humidity, float pressure);
+
+// Períodos ainda no anel: [history_first(), history_end()). history_end() é o período em andamento
+uint32_t history_first(void);
+uint32_t history_end(void);
+
+// Média dos registros dos períodos [period, period + count). Retorna false se nenhum deles tem registro
+bool history_get(uint32_t period, uint32_t count, history_point_t *out);
+
+#endif // HISTORY_H
@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_parser.h"
+
+#define HTTP_METHOD_MAX 8
+#define HTTP_VERSION_MAX 9 // "HTTP/1.1" + '\0'
+
+// Cabeçalhos reconhecidos. Os nomes estão em minúsculas, como são comparados
+enum {
+    HDR_OTHER,
+    HDR_IF_NONE_MATCH,
+    HDR_ACCEPT_ENCODING,
+    HDR_CONNECTION,
+    HDR_UPGRADE,
+    HDR_WS_KEY,
+    HDR_LAST_EVENT_ID,
+    HDR_CONTENT_LENGTH
+};
+
+static const char *const HEADER_NAMES[] = {
+    [HDR_IF_NONE_MATCH] = "if-none-match",
+    [HDR_ACCEPT_ENCODING] = "accept-encoding",
+    [HDR_CONNECTION] = "connection",
+    [HDR_UPGRADE] = "upgrade",
+    [HDR_WS_KEY] = "sec-websocket-key",
+    [HDR_LAST_EVENT_ID] = "last-event-id",
+    [HDR_CONTENT_LENGTH] = "content-length",
+};
+#define NUM_HEADERS (sizeof(HEADER_NAMES) / sizeof(HEADER_NAMES[0]))
+
+static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+// Procura uma palavra (sem diferenciar maiúsculas) numa lista separada por vírgulas ou espaços
+static bool has_token(const char *list, const char *token) {
+    size_t n = strlen(token);
+    const char *p = list;
+    while (*p) {
+        while (*p == ' ' || *p == ',' || *p == '\t') p++;
+        size_t i = 0;
+        while (i < n && p[i] && lower(p[i]) == token[i]) i++;
+        if (i == n && (p[n] == '\0' || p[n] == ',' || p[n] == ' ' || p[n] == ';' || p[n] == '\t')) {
+            return true;
+        }
+        while (*p && *p != ',') p++;
+    }
+    return false;
+}
+
+void http_parser_init(http_parser_t *parser) {
+    memset(parser, 0, offsetof(http_parser_t, target));
+    parser->target[0] = '\0';
+    parser->etag[0] = '\0';
+    parser->ws_key[0] = '\0';
+    parser->state = HTTP_PARSE_METHOD;
+    parser->pos = 0;
+    parser->header = HDR_OTHER;
+    parser->value_len = 0;
+    parser->body_left = 0;
+}
+
+static void fail(http_parser_t *parser, uint16_t status) {
+    parser->state = HTTP_PARSE_ERROR;
+    parser->error = status;
+}
+
+static void finish_method(http_parser_t *parser) {
+    parser->name[parser->pos] = '\0';
+    if (strcmp(parser->name, "GET") == 0) parser->method = HTTP_METHOD_GET;
+    else if (strcmp(parser->name, "HEAD") == 0) parser->method = HTTP_METHOD_HEAD;
+    else if (strcmp(parser->name, "POST") == 0) parser->method = HTTP_METHOD_POST;
+    else parser->method = HTTP_METHOD_UNKNOWN;
+}
+
+static bool finish_version(http_parser_t *parser) {
+    parser->name[parser->pos] = '\0';
+    if (strcmp(parser->name, "HTTP/1.1") == 0) {
+        parser->flags |= HTTP_FLAG_HTTP11;
+        return true;
+    }
+    return strcmp(parser->name, "HTTP/1.0") == 0;
+}
+
+static void finish_header_name(http_parser_t *parser) {
+    parser->header = HDR_OTHER;
+    if (parser->pos > HTTP_HEADER_NAME_MAX - 1) return; // Nome truncado: não é nenhum dos conhecidos
+
+    parser->name[parser->pos] = '\0';
+    for (unsigned i = 1; i < NUM_HEADERS; i++) {
+        if (strcmp(parser->name, HEADER_NAMES[i]) == 0) {
+            parser->header = (uint8_t)i;
+            break;
+        }
+    }
+}
+
+// Guarda um caractere do valor do cabeçalho atual no campo correspondente
+static void header_value_char(http_parser_t *parser, char c) {
+    switch (parser->header) {
+        case HDR_IF_NONE_MATCH:
+            // Guarda sem aspas e sem o prefixo de ETag fraca
+            if (c == '"' || (parser->value_len == 0 && c == 'W') || (parser->value_len == 0 && c == '/')) return;
+            if (parser->value_len < HTTP_ETAG_MAX - 1) {
+                parser->etag[parser->value_len++] = c;
+                parser->etag[parser->value_len] = '\0';
+            }
+            break;
+
+        case HDR_WS_KEY:
+            if (parser->value_len < HTTP_WS_KEY_MAX - 1) {
+                parser->ws_key[parser->value_len++] = c;
+                parser->ws_key[parser->value_len] = '\0';
+            }
+            break;
+
+        case HDR_OTHER:
+            break;
+
+        default:
+            if (parser->value_len < HTTP_TOKEN_MAX - 1) {
+                parser->value[parser->value_len++] = c;
+            }
+            break;
+    }
+}
+
+static void finish_header_value(http_parser_t *parser) {
+    parser->value[parser->value_len] = '\0';
+
+    switch (parser->header) {
+        case HDR_CONNECTION:
+            if (has_token(parser->value, "close")) parser->flags |= HTTP_FLAG_CONN_CLOSE;
+            if (has_token(parser->value, "keep-alive")) parser->flags |= HTTP_FLAG_CONN_KEEPALIVE;
+            if (has_token(parser->value, "upgrade")) parser->flags |= HTTP_FLAG_CONN_UPGRADE;
+            break;
+        case HDR_UPGRADE:
+            if (has_token(parser->value, "websocket")) parser->flags |= HTTP_FLAG_UPGRADE_WS;
+            break;
+        case HDR_ACCEPT_ENCODING:
+            if (has_token(parser->value, "gzip")) parser->flags |= HTTP_FLAG_ACCEPT_GZIP;
+            break;
+        case HDR_LAST_EVENT_ID:
+            parser->last_event_id = strtoul(parser->value, NULL, 10);
+            parser->flags |= HTTP_FLAG_LAST_EVENT_ID;
+            break;
+        case HDR_CONTENT_LENGTH:
+            parser->content_length = strtoul(parser->value, NULL, 10);
+            break;
+    }
+}
+
+size_t http_parser_feed(http_parser_t *parser, const char *data, size_t len) {
+    size_t i = 0;
+
+    while (i < len && parser->state != HTTP_PARSE_DONE && parser->state != HTTP_PARSE_ERROR) {
+        char c = data[i++];
+
+        switch (parser->state) {
+            case HTTP_PARSE_METHOD:
+                if (c == ' ') {
+                    finish_method(parser);
+                    parser->state = HTTP_PARSE_TARGET;
+                } else if ((c == '\r' || c == '\n') && parser->pos == 0) {
+                    // Linhas vazias antes da requisição são ignoradas (RFC 9112, 2.2)
+                } else if (c >= 'A' && c <= 'Z' && parser->pos < HTTP_METHOD_MAX - 1) {
+                    parser->name[parser->pos++] = c;
+                } else {
+                    fail(parser, 400);
+                }
+                break;
+
+            case HTTP_PARSE_TARGET:
+                if (c == ' ') {
+                    if (parser->target_len == 0 || parser->target[0] != '/') {
+                        fail(parser, 400);
+                        break;
+                    }
+                    parser->target[parser->target_len] = '\0';
+                    if (parser->path_len == 0) parser->path_len = parser->target_len;
+                    parser->pos = 0;
+                    parser->state = HTTP_PARSE_VERSION;
+                } else if (c == '\r' || c == '\n') {
+                    fail(parser, 400);
+                } else if (parser->target_len >= HTTP_TARGET_MAX - 1) {
+                    fail(parser, 414);
+                } else {
+                    if (c == '?' && parser->path_len == 0) parser->path_len = parser->target_len;
+                    parser->target[parser->target_len++] = c;
+                }
+                break;
+
+            case HTTP_PARSE_VERSION:
+                if (c == '\r' || c == '\n') {
+                    if (!finish_version(parser)) {
+                        fail(parser, 505);
+                        break;
+                    }
+                    parser->state = (c == '\r') ? HTTP_PARSE_REQUEST_LF : HTTP_PARSE_HEADER_START;
+                } else if (parser->pos < HTTP_VERSION_MAX - 1) {
+                    parser->name[parser->pos++] = c;
+                } else {
+                    fail(parser, 505);
+                }
+                break;
+
+            case HTTP_PARSE_REQUEST_LF:
+            case HTTP_PARSE_HEADER_LF:
+                if (c != '\n') {
+                    fail(parser, 400);
+                    break;
+                }
+                parser->state = HTTP_PARSE_HEADER_START;
+                break;
+
+            case HTTP_PARSE_HEADER_START:
+                if (c == '\r') {
+                    parser->state = HTTP_PARSE_END_LF;
+                    break;
+                }
+                if (c == '\n') {
+                    parser->state = HTTP_PARSE_END_LF;
+                    i--; // Reprocessa como o fim do cabeçalho
+                    break;
+                }
+                parser->pos = 0;
+                parser->value_len = 0;
+                parser->state = HTTP_PARSE_HEADER_NAME;
+                // fall through
+
+            case HTTP_PARSE_HEADER_NAME:
+                if (c == ':') {
+                    finish_header_name(parser);
+                    parser->state = HTTP_PARSE_HEADER_SPACE;
+                } else if (c == '\r' || c == '\n') {
+                    fail(parser, 400);
+                } else {
+                    if (parser->pos < HTTP_HEADER_NAME_MAX - 1) {
+                        parser->name[parser->pos] = lower(c);
+                    }
+                    if (parser->pos < 0xFF) parser->pos++;
+                }
+                break;
+
+            case HTTP_PARSE_HEADER_SPACE:
+                if (c == ' ' || c == '\t') break;
+                parser->state = HTTP_PARSE_HEADER_VALUE;
+                // fall through
+
+            case HTTP_PARSE_HEADER_VALUE:
+                if (c == '\r' || c == '\n') {
+                    finish_header_value(parser);
+                    parser->state = (c == '\r') ? HTTP_PARSE_HEADER_LF : HTTP_PARSE_HEADER_START;
+                } else {
+                    header_value_char(parser, c);
+                }
+                break;
+
+            case HTTP_PARSE_END_LF:
+                if (c != '\n') {
+                    fail(parser, 400);
+                    break;
+                }
+                parser->body_left = parser->content_length;
+                parser->state = parser->body_left ? HTTP_PARSE_BODY : HTTP_PARSE_DONE;
+                break;
+
+            case HTTP_PARSE_BODY: {
+                // O servidor não usa o corpo: só o descarta
+                size_t n = len - i + 1;
+                if (n > parser->body_left) n = parser->body_left;
+                parser->body_left -= n;
+                i += n - 1;
+                if (!parser->body_left) parser->state = HTTP_PARSE_DONE;
+                break;
+            }
+        }
+    }
+
+    return i;
+}
+
+bool http_path_is(const http_parser_t *parser, const char *path) {
+    size_t n = strlen(path);
+    return parser->path_len == n && memcmp(parser->target, path, n) == 0;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = lower(c);
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool http_query_get(const http_parser_t *parser, const char *key, char *out, size_t out_size) {
+    if (parser->path_len >= parser->target_len) return false;
+
+    size_t key_len = strlen(key);
+    const char *p = parser->target + parser->path_len + 1; // Depois do '?'
+
+    while (*p) {
+        const char *fim = strchr(p, '&');
+        if (!fim) fim = p + strlen(p);
+
+        if ((size_t)(fim - p) >= key_len && memcmp(p, key, key_len) == 0
+            && (p[key_len] == '=' || p + key_len == fim)) {
+            const char *v = (p[key_len] == '=') ? p + key_len + 1 : fim;
+            size_t n = 0;
+            while (v < fim && n + 1 < out_size) {
+                if (*v == '+') {
+                    out[n++] = ' ';
+                    v++;
+                } else if (*v == '%' && fim - v >= 3 && hex_value(v[1]) >= 0 && hex_value(v[2]) >= 0) {
+                    out[n++] = (char)(hex_value(v[1]) * 16 + hex_value(v[2]));
+                    v += 3;
+                } else {
+                    out[n++] = *v++;
+                }
+            }
+            if (out_size) out[n] = '\0';
+            return true;
+        }
+
+        p = *fim ? fim + 1 : fim;
+    }
+    return false;
+}
+
+bool http_query_get_float(const http_parser_t *parser, const char *key, float *out) {
+    char buf[24];
+    if (!http_query_get(parser, key, buf, sizeof(buf))) return false;
+
+    char *end;
+    float v = strtof(buf, &end);
+    if (end == buf) return false; // Valor vazio ou não numérico
+    *out = v;
+    return true;
+}
+
+bool http_query_get_u32(const http_parser_t *parser, const char *key, uint32_t *out) {
+    char buf[16];
+    if (!http_query_get(parser, key, buf, sizeof(buf))) return false;
+
+    char *end;
+    unsigned long v = strtoul(buf, &end, 10);
+    if (end == buf) return false;
+    *out = (uint32_t)v;
+    return true;
+}
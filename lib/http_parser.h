@@ -0,0 +1,101 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define HTTP_TARGET_MAX 128     // Caminho + query da requisição, incluindo '\0'
+#define HTTP_ETAG_MAX 24        // Valor de If-None-Match
+#define HTTP_WS_KEY_MAX 32      // Valor de Sec-WebSocket-Key (24 caracteres em base64)
+#define HTTP_HEADER_NAME_MAX 20 // Cabeçalhos com nome maior não interessam e são ignorados
+#define HTTP_TOKEN_MAX 48       // Valores de Connection, Upgrade e Accept-Encoding
+
+typedef enum {
+    HTTP_METHOD_UNKNOWN,
+    HTTP_METHOD_GET,
+    HTTP_METHOD_HEAD,
+    HTTP_METHOD_POST
+} http_method_t;
+
+// Flags extraídas dos cabeçalhos
+#define HTTP_FLAG_HTTP11         0x01 // Versão 1.1 (keep-alive por padrão)
+#define HTTP_FLAG_CONN_CLOSE     0x02 // Connection: close
+#define HTTP_FLAG_CONN_KEEPALIVE 0x04 // Connection: keep-alive
+#define HTTP_FLAG_CONN_UPGRADE   0x08 // Connection: Upgrade
+#define HTTP_FLAG_UPGRADE_WS     0x10 // Upgrade: websocket
+#define HTTP_FLAG_ACCEPT_GZIP    0x20 // Accept-Encoding contém gzip
+#define HTTP_FLAG_LAST_EVENT_ID  0x40 // Last-Event-ID presente
+
+typedef enum {
+    HTTP_PARSE_METHOD,
+    HTTP_PARSE_TARGET,
+    HTTP_PARSE_VERSION,
+    HTTP_PARSE_REQUEST_LF,
+    HTTP_PARSE_HEADER_START,
+    HTTP_PARSE_HEADER_NAME,
+    HTTP_PARSE_HEADER_SPACE,
+    HTTP_PARSE_HEADER_VALUE,
+    HTTP_PARSE_HEADER_LF,
+    HTTP_PARSE_END_LF,
+    HTTP_PARSE_BODY,
+    HTTP_PARSE_DONE,   // Requisição completa
+    HTTP_PARSE_ERROR   // Requisição inválida; status em http_parser_t.error
+} http_parse_state_t;
+
+/**
+ * Parser incremental de requisições HTTP/1.x. Recebe os bytes na ordem em que chegam,
+ * em quantos pedaços forem necessários, e guarda apenas os campos usados pelo servidor.
+ */
+typedef struct {
+    // Resultado
+    uint8_t method;               // http_method_t
+    uint8_t flags;                // HTTP_FLAG_*
+    uint16_t error;               // Status HTTP a responder quando state == HTTP_PARSE_ERROR
+    uint16_t path_len;            // Tamanho do caminho em target (até o '?')
+    uint16_t target_len;
+    uint32_t content_length;
+    uint32_t last_event_id;
+    char target[HTTP_TARGET_MAX]; // Caminho e query, terminados em '\0'
+    char etag[HTTP_ETAG_MAX];     // If-None-Match, sem aspas
+    char ws_key[HTTP_WS_KEY_MAX]; // Sec-WebSocket-Key
+
+    // Estado interno
+    uint8_t state;                // http_parse_state_t
+    uint8_t pos;                  // Posição no método, versão ou nome do cabeçalho
+    uint8_t header;               // Cabeçalho sendo lido
+    uint8_t value_len;
+    char name[HTTP_HEADER_NAME_MAX];
+    char value[HTTP_TOKEN_MAX];
+    uint32_t body_left;
+} http_parser_t;
+
+void http_parser_init(http_parser_t *parser);
+
+/**
+ * Consome até len bytes. Para assim que a requisição termina (HTTP_PARSE_DONE) ou é
+ * inválida (HTTP_PARSE_ERROR) e retorna quantos bytes foram consumidos; o restante
+ * pertence à próxima requisição.
+ */
+size_t http_parser_feed(http_parser_t *parser, const char *data, size_t len);
+
+static inline bool http_parser_done(const http_parser_t *parser) {
+    return parser->state == HTTP_PARSE_DONE;
+}
+
+static inline bool http_parser_failed(const http_parser_t *parser) {
+    return parser->state == HTTP_PARSE_ERROR;
+}
+
+// Compara o caminho da requisição (sem a query)
+bool http_path_is(const http_parser_t *parser, const char *path);
+
+/**
+ * Obtém o valor de um parâmetro da query, decodificando %XX e '+'.
+ * Retorna false se o parâmetro não existe.
+ */
+bool http_query_get(const http_parser_t *parser, const char *key, char *out, size_t out_size);
+bool http_query_get_float(const http_parser_t *parser, const char *key, float *out);
+bool http_query_get_u32(const http_parser_t *parser, const char *key, uint32_t *out);
+
+#endif // HTTP_PARSER_H
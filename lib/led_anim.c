@@ -0,0 +1,113 @@
+#include "led_anim.h"
+#include "prof.h"
+
+/**
+ * Correção de gama aproximada por 0,8x² + 0,2x³ (próxima de x^2,2), em inteiros para ser avaliada
+ * pelo compilador. GAMMA_B aplica ainda o brilho máximo b.
+ */
+#define GAMMA(x) ((4u * (x) * (x) * 255u + (x) * (x) * (x)) / (5u * 255u * 255u))
+#define GAMMA_B(x, b) ((GAMMA(x) * (b) + 127u) / 255u)
+
+#define LUT4(i, b) GAMMA_B(i, b), GAMMA_B((i) + 1u, b), GAMMA_B((i) + 2u, b), GAMMA_B((i) + 3u, b)
+#define LUT16(i, b) LUT4(i, b), LUT4((i) + 4u, b), LUT4((i) + 8u, b), LUT4((i) + 12u, b)
+#define LUT64(i, b) LUT16(i, b), LUT16((i) + 16u, b), LUT16((i) + 32u, b), LUT16((i) + 48u, b)
+#define LUT256(b) { LUT64(0u, b), LUT64(64u, b), LUT64(128u, b), LUT64(192u, b) }
+
+// Saída de cada canal por nível de brilho. O nível 0 corresponde à intensidade 4 usada antes pela matriz
+static const uint8_t gamma_lut[LED_ANIM_BRIGHTNESS_LEVELS][256] = {
+    LUT256(4u),
+    LUT256(16u),
+    LUT256(64u),
+    LUT256(255u)
+};
+
+static void led_anim_render(led_anim_t *anim) {
+    uint32_t frame[WS2812_MAX_LEDS];
+    const uint8_t *lut = gamma_lut[anim->brightness];
+
+    // Transição suave: percorre uma fração fixa da distância até o alvo
+    float alvo = anim->target_level;
+    anim->level += (alvo - anim->level) * LED_ANIM_SMOOTH;
+    if (anim->level - alvo < 0.01f && alvo - anim->level < 0.01f)
+        anim->level = alvo;
+    for (int c = 0; c < 3; ++c)
+        anim->rgb[c] += (anim->target_rgb[c] - anim->rgb[c]) * LED_ANIM_SMOOTH;
+
+    anim->frame_count++;
+    bool apagado = anim->alarm && (anim->frame_count / LED_ANIM_BLINK_FRAMES) % 2;
+
+    for (uint8_t i = 0; i < anim->ws->num_leds; ++i) {
+        float intensidade = anim->level - i;
+        if (intensidade > 1.0f) intensidade = 1.0f;
+        if (intensidade < 0.0f || apagado) intensidade = 0.0f;
+
+        uint8_t r = (uint8_t)(anim->rgb[0] * intensidade + 0.5f);
+        uint8_t g = (uint8_t)(anim->rgb[1] * intensidade + 0.5f);
+        uint8_t b = (uint8_t)(anim->rgb[2] * intensidade + 0.5f);
+        frame[i] = ws2812_rgb(lut[r], lut[g], lut[b]);
+    }
+
+    // Quadros iguais ao anterior são descartados pelo driver: parado, a matriz não gera tráfego
+    ws2812_show(anim->ws, frame);
+}
+
+static bool led_anim_frame(repeating_timer_t *rt) {
+    PROF_SCOPE(PROF_MATRIZ) {
+        led_anim_render((led_anim_t *)rt->user_data);
+    }
+    return true;
+}
+
+void led_anim_init(led_anim_t *anim, ws2812_t *ws) {
+    anim->ws = ws;
+    anim->target_level = 0.0f;
+    anim->level = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        anim->target_rgb[c] = 0.0f;
+        anim->rgb[c] = 0.0f;
+    }
+    anim->alarm = false;
+    anim->brightness = 0;
+    anim->frame_count = 0;
+
+    // Período negativo: intervalo medido entre inícios de quadro, sem acumular atraso
+    add_repeating_timer_us(-1000000 / LED_ANIM_FPS, led_anim_frame, anim, &anim->timer);
+}
+
+void led_anim_set_bar(led_anim_t *anim, float leds, uint8_t r, uint8_t g, uint8_t b) {
+    if (leds < 0.0f) leds = 0.0f;
+    if (leds > anim->ws->num_leds) leds = anim->ws->num_leds;
+    anim->target_rgb[0] = r;
+    anim->target_rgb[1] = g;
+    anim->target_rgb[2] = b;
+    anim->target_level = leds;
+}
+
+void led_anim_set_value(led_anim_t *anim, float value, float min, float max, const led_anim_stop_t *stops, uint8_t num_stops) {
+    float t = (max > min) ? (value - min) / (max - min) : 0.0f;
+    if (!(t > 0.0f)) t = 0.0f; // Também trata NaN
+    if (t > 1.0f) t = 1.0f;
+
+    // Interpola entre os dois pontos do gradiente que cercam t
+    uint8_t i = 0;
+    while (i + 1 < num_stops && stops[i + 1].pos < t)
+        i++;
+    const led_anim_stop_t *a = &stops[i];
+    const led_anim_stop_t *b = (i + 1 < num_stops) ? &stops[i + 1] : a;
+    float f = (b->pos > a->pos) ? (t - a->pos) / (b->pos - a->pos) : 0.0f;
+    if (f < 0.0f) f = 0.0f;
+    if (f > 1.0f) f = 1.0f;
+
+    led_anim_set_bar(anim, t * anim->ws->num_leds,
+                     (uint8_t)(a->r + (b->r - a->r) * f + 0.5f),
+                     (uint8_t)(a->g + (b->g - a->g) * f + 0.5f),
+                     (uint8_t)(a->b + (b->b - a->b) * f + 0.5f));
+}
+
+void led_anim_set_alarm(led_anim_t *anim, bool on) {
+    anim->alarm = on;
+}
+
+void led_anim_set_brightness(led_anim_t *anim, uint8_t level) {
+    anim->brightness = level < LED_ANIM_BRIGHTNESS_LEVELS ? level : LED_ANIM_BRIGHTNESS_LEVELS - 1;
+}
@@ -0,0 +1,55 @@
+#ifndef LED_ANIM_H
+#define LED_ANIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "ws2812.h"
+
+#define LED_ANIM_FPS 50            // Quadros por segundo do temporizador
+#define LED_ANIM_SMOOTH 0.15f      // Fração da distância ao alvo percorrida por quadro (~130 ms de constante de tempo)
+#define LED_ANIM_BLINK_FRAMES 12   // Quadros acesos/apagados no pisca de alarme (~2 Hz)
+#define LED_ANIM_BRIGHTNESS_LEVELS 4
+
+// Cor de um ponto do gradiente, na posição pos (0 a 1)
+typedef struct {
+    float pos;
+    uint8_t r, g, b;
+} led_anim_stop_t;
+
+/**
+ * Animação da matriz de LEDs: uma barra de LEDs acesos em ordem, com transições suaves de
+ * comprimento e cor e pisca em alarme. Os quadros são gerados por um temporizador repetitivo,
+ * com taxa fixa independente do laço principal; as funções led_anim_set_* só mudam o alvo.
+ * As cores passam por correção de gama e brilho com tabelas geradas na compilação.
+ */
+typedef struct {
+    ws2812_t *ws;
+    repeating_timer_t timer;
+    volatile float target_level;   // LEDs acesos (pode ser fracionário: o último LED acende parcialmente)
+    volatile float target_rgb[3];
+    volatile bool alarm;
+    volatile uint8_t brightness;   // 0 a LED_ANIM_BRIGHTNESS_LEVELS - 1
+    float level;                   // Estado exibido, aproximando-se do alvo a cada quadro
+    float rgb[3];
+    uint16_t frame_count;
+} led_anim_t;
+
+// Inicia a animação com a matriz apagada
+void led_anim_init(led_anim_t *anim, ws2812_t *ws);
+
+// Barra de leds LEDs acesos com a cor dada (escala completa, 0 a 255)
+void led_anim_set_bar(led_anim_t *anim, float leds, uint8_t r, uint8_t g, uint8_t b);
+
+/**
+ * Barra proporcional a value entre min e max, com a cor do gradiente nessa mesma posição.
+ * Os pontos do gradiente devem estar em ordem crescente de pos.
+ */
+void led_anim_set_value(led_anim_t *anim, float value, float min, float max, const led_anim_stop_t *stops, uint8_t num_stops);
+
+// Pisca a barra enquanto o alarme estiver ativo
+void led_anim_set_alarm(led_anim_t *anim, bool on);
+
+void led_anim_set_brightness(led_anim_t *anim, uint8_t level);
+
+#endif // LED_ANIM_H
@@ -0,0 +1,215 @@
+#include <malloc.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <reent.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "lwip/memp.h"
+#include "lwip/stats.h"
+
+#include "memstats.h"
+#include "metrics.h"
+
+#define MEMSTATS_PAINT 0x5AA5C33Cu   // Valor das palavras de pilha nunca usadas
+#define MEMSTATS_PAINT_MARGIN 64     // Bytes logo abaixo do quadro atual deixados sem pintar
+
+// Símbolos do script de linker do SDK
+extern uint32_t __StackBottom, __StackTop;       // Núcleo 0 (SCRATCH_Y)
+extern uint32_t __StackOneBottom, __StackOneTop; // Núcleo 1 (SCRATCH_X)
+extern char end, __StackLimit;                   // Limites do heap
+
+static memstats_heap_t heap;
+
+// Nome de cada pool do lwIP, na ordem de memp_t
+static const char *const nomes_pools[MEMP_MAX] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+
+static void memstats_paint(uint32_t *bottom, uint32_t *top) {
+    for (uint32_t *p = bottom; p < top; p++) {
+        *p = MEMSTATS_PAINT;
+    }
+}
+
+// Partes de /metrics: pilhas e heap, heap do lwIP e uma por família dos pools
+static void memstats_collect(metrics_writer_t *w, unsigned part) {
+    static const char *const familias_pools[][2] = {
+        { "station_lwip_pool_used", "Blocos em uso por pool do lwIP" },
+        { "station_lwip_pool_peak", "Maior uso de cada pool do lwIP" },
+        { "station_lwip_pool_size", "Blocos de cada pool do lwIP" },
+        { "station_lwip_pool_errors_total", "Alocacoes recusadas por pool do lwIP" },
+    };
+    char labels[32];
+
+    if (part == 0) {
+        memstats_stack_t s[2];
+        memstats_stack(0, &s[0]);
+        memstats_stack(1, &s[1]);
+        metrics_family(w, "station_stack_used_bytes", "gauge", "Maior profundidade ja alcancada pela pilha de cada nucleo");
+        metrics_uint(w, "station_stack_used_bytes", "core=\"0\"", s[0].used);
+        metrics_uint(w, "station_stack_used_bytes", "core=\"1\"", s[1].used);
+        metrics_family(w, "station_stack_size_bytes", "gauge", "Pilha reservada para cada nucleo");
+        metrics_uint(w, "station_stack_size_bytes", "core=\"0\"", s[0].size);
+        metrics_uint(w, "station_stack_size_bytes", "core=\"1\"", s[1].size);
+
+        memstats_heap_t h;
+        memstats_heap(&h);
+        metrics_family(w, "station_heap_used_bytes", "gauge", "Bytes alocados por malloc");
+        metrics_uint(w, "station_heap_used_bytes", NULL, h.current);
+        metrics_family(w, "station_heap_peak_bytes", "gauge", "Maior uso do heap desde o boot");
+        metrics_uint(w, "station_heap_peak_bytes", NULL, h.peak);
+        metrics_family(w, "station_heap_size_bytes", "gauge", "Memoria disponivel para o heap");
+        metrics_uint(w, "station_heap_size_bytes", NULL, memstats_heap_size());
+        metrics_family(w, "station_heap_allocs_total", "counter", "Alocacoes com malloc, calloc e realloc");
+        metrics_uint(w, "station_heap_allocs_total", NULL, h.allocs);
+        metrics_family(w, "station_heap_frees_total", "counter", "Blocos liberados");
+        metrics_uint(w, "station_heap_frees_total", NULL, h.frees);
+        metrics_family(w, "station_heap_failures_total", "counter", "Alocacoes que falharam");
+        metrics_uint(w, "station_heap_failures_total", NULL, h.failures);
+    } else if (part == 1) {
+        metrics_family(w, "station_lwip_mem_used_bytes", "gauge", "Bytes em uso no heap do lwIP");
+        metrics_uint(w, "station_lwip_mem_used_bytes", NULL, lwip_stats.mem.used);
+        metrics_family(w, "station_lwip_mem_peak_bytes", "gauge", "Maior uso do heap do lwIP");
+        metrics_uint(w, "station_lwip_mem_peak_bytes", NULL, lwip_stats.mem.max);
+        metrics_family(w, "station_lwip_mem_size_bytes", "gauge", "Tamanho do heap do lwIP (MEM_SIZE)");
+        metrics_uint(w, "station_lwip_mem_size_bytes", NULL, lwip_stats.mem.avail);
+        metrics_family(w, "station_lwip_mem_errors_total", "counter", "Alocacoes recusadas no heap do lwIP");
+        metrics_uint(w, "station_lwip_mem_errors_total", NULL, lwip_stats.mem.err);
+    } else {
+        unsigned f = part - 2;
+        metrics_family(w, familias_pools[f][0], f == 3 ? "counter" : "gauge", familias_pools[f][1]);
+        for (unsigned i = 0; i < MEMP_MAX; i++) {
+            const struct stats_mem *m = lwip_stats.memp[i];
+            uint32_t valores[4] = { m->used, m->max, m->avail, m->err };
+            snprintf(labels, sizeof(labels), "pool=\"%s\"", nomes_pools[i]);
+            metrics_uint(w, familias_pools[f][0], labels, valores[f]);
+        }
+    }
+}
+
+void memstats_init(void) {
+    uint32_t *sp = (uint32_t *)__builtin_frame_address(0);
+    memstats_paint(&__StackBottom, sp - MEMSTATS_PAINT_MARGIN / 4);
+
+    // O núcleo 1 não foi iniciado; o topo da pilha dele fica livre para o que a bootrom tiver ali
+    memstats_paint(&__StackOneBottom, &__StackOneTop - MEMSTATS_PAINT_MARGIN / 4);
+
+    metrics_register(memstats_collect, 6);
+}
+
+void memstats_stack(unsigned core, memstats_stack_t *out) {
+    uint32_t *bottom = core ? &__StackOneBottom : &__StackBottom;
+    uint32_t *top = core ? &__StackOneTop : &__StackTop;
+
+    uint32_t *p = bottom;
+    while (p < top && *p == MEMSTATS_PAINT) p++;
+
+    out->size = (top - bottom) * 4;
+    out->used = (top - p) * 4;
+}
+
+void memstats_heap(memstats_heap_t *out) {
+    uint32_t irq = save_and_disable_interrupts();
+    *out = heap;
+    restore_interrupts(irq);
+}
+
+uint32_t memstats_heap_size(void) {
+    return &__StackLimit - &end;
+}
+
+size_t memstats_format(char *buf, size_t size) {
+    memstats_stack_t s;
+    memstats_heap_t h;
+    size_t n = 0;
+
+    for (unsigned core = 0; core < 2 && n < size; core++) {
+        memstats_stack(core, &s);
+        n += snprintf(buf + n, size - n, "pilha %u: %lu de %lu bytes%s\n", core,
+                      (unsigned long)s.used, (unsigned long)s.size, s.used == s.size ? " (ESTOURO)" : "");
+    }
+
+    memstats_heap(&h);
+    if (n < size) {
+        n += snprintf(buf + n, size - n, "heap: %lu bytes (pico %lu) de %lu, %lu malloc, %lu free, %lu falhas\n",
+                      (unsigned long)h.current, (unsigned long)h.peak, (unsigned long)memstats_heap_size(),
+                      (unsigned long)h.allocs, (unsigned long)h.frees, (unsigned long)h.failures);
+    }
+    if (n < size) {
+        n += snprintf(buf + n, size - n, "lwip mem: %lu bytes (pico %lu) de %lu, %lu falhas\n",
+                      (unsigned long)lwip_stats.mem.used, (unsigned long)lwip_stats.mem.max,
+                      (unsigned long)lwip_stats.mem.avail, (unsigned long)lwip_stats.mem.err);
+    }
+    for (unsigned i = 0; i < MEMP_MAX && n < size; i++) {
+        const struct stats_mem *m = lwip_stats.memp[i];
+        n += snprintf(buf + n, size - n, "lwip %-16s %3lu (pico %3lu) de %3lu, %lu falhas\n", nomes_pools[i],
+                      (unsigned long)m->used, (unsigned long)m->max, (unsigned long)m->avail, (unsigned long)m->err);
+    }
+    return n < size ? n : size - 1;
+}
+
+// ======== WRAPPERS DO MALLOC ===========
+// Ligados com -Wl,--wrap. O SDK já envolve malloc/free; as versões reentrantes são as chamadas por elas,
+// por calloc e por realloc, então todo bloco passa por aqui
+
+void *__real__malloc_r(struct _reent *r, size_t size);
+void __real__free_r(struct _reent *r, void *ptr);
+void *__real__realloc_r(struct _reent *r, void *ptr, size_t size);
+
+// O realloc pode chamar _malloc_r e _free_r (ao mover ou dividir o bloco); ele mesmo contabiliza o resultado
+static volatile bool em_realloc = false;
+
+void *__wrap__malloc_r(struct _reent *r, size_t size) {
+    void *p = __real__malloc_r(r, size);
+    if (em_realloc) return p;
+    size_t util = p ? _malloc_usable_size_r(r, p) : 0;
+
+    uint32_t irq = save_and_disable_interrupts();
+    if (p) {
+        heap.allocs++;
+        heap.current += util;
+        if (heap.current > heap.peak) heap.peak = heap.current;
+    } else {
+        heap.failures++;
+    }
+    restore_interrupts(irq);
+    return p;
+}
+
+void __wrap__free_r(struct _reent *r, void *ptr) {
+    if (!ptr || em_realloc) {
+        __real__free_r(r, ptr);
+        return;
+    }
+    size_t util = _malloc_usable_size_r(r, ptr);
+    __real__free_r(r, ptr);
+
+    uint32_t irq = save_and_disable_interrupts();
+    heap.frees++;
+    heap.current -= util;
+    restore_interrupts(irq);
+}
+
+void *__wrap__realloc_r(struct _reent *r, void *ptr, size_t size) {
+    size_t antes = ptr ? _malloc_usable_size_r(r, ptr) : 0;
+    em_realloc = true;
+    void *p = __real__realloc_r(r, ptr, size);
+    em_realloc = false;
+    size_t depois = p ? _malloc_usable_size_r(r, p) : 0;
+
+    uint32_t irq = save_and_disable_interrupts();
+    if (p || !size) { // realloc(ptr, 0) pode liberar o bloco e retornar NULL
+        heap.current += depois - antes;
+        if (heap.current > heap.peak) heap.peak = heap.current;
+        if (p != ptr) {
+            if (p) heap.allocs++;
+            if (ptr) heap.frees++;
+        }
+    } else {
+        heap.failures++;
+    }
+    restore_interrupts(irq);
+    return p;
+}
@@ -0,0 +1,39 @@
+#ifndef MEMSTATS_H
+#define MEMSTATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MEMSTATS_TEXT_MAX 1536 // Relatório de memstats_format
+
+// Uso do heap contado pelos wrappers de _malloc_r/_free_r/_realloc_r (tamanho útil de cada bloco)
+typedef struct {
+    uint32_t current;   // Bytes alocados agora
+    uint32_t peak;      // Maior valor de current desde o boot
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;  // Alocações que retornaram NULL
+} memstats_heap_t;
+
+typedef struct {
+    uint32_t size;      // Tamanho reservado pelo linker
+    uint32_t used;      // Maior profundidade já alcançada (marca d'água)
+} memstats_stack_t;
+
+/**
+ * Pinta as pilhas dos dois núcleos com um padrão conhecido e registra as métricas de memória. Deve
+ * ser a primeira chamada de main: só a parte abaixo do quadro atual é pintada, e a marca d'água é a
+ * última palavra já sobrescrita.
+ */
+void memstats_init(void);
+
+void memstats_stack(unsigned core, memstats_stack_t *out);
+void memstats_heap(memstats_heap_t *out);
+
+// Bytes entre o fim dos dados estáticos e o início das pilhas, que o malloc pode usar
+uint32_t memstats_heap_size(void);
+
+// Relatório em texto: pilhas, heap e pools do lwIP. Chamar com o lwIP bloqueado ou no contexto dele
+size_t memstats_format(char *buf, size_t size);
+
+#endif // MEMSTATS_H
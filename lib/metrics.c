@@ -0,0 +1,129 @@
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "hardware/sync.h"
+#include "metrics.h"
+
+static metrics_collector_t coletores[METRICS_MAX_COLLECTORS];
+static uint8_t partes[METRICS_MAX_COLLECTORS];
+static unsigned num_coletores = 0;
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t size) {
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = false;
+}
+
+// Acrescenta uma linha inteira ou nada
+static void metrics_printf(metrics_writer_t *w, const char *fmt, ...) {
+    if (w->overflow) return;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(w->buf + w->len, w->size - w->len, fmt, args);
+    va_end(args);
+
+    if (n < 0 || (size_t)n >= w->size - w->len) {
+        w->overflow = true;
+        return;
+    }
+    w->len += n;
+}
+
+void metrics_family(metrics_writer_t *w, const char *name, const char *type, const char *help) {
+    metrics_printf(w, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void metrics_uint(metrics_writer_t *w, const char *name, const char *labels, uint32_t value) {
+    if (labels) {
+        metrics_printf(w, "%s{%s} %lu\n", name, labels, (unsigned long)value);
+    } else {
+        metrics_printf(w, "%s %lu\n", name, (unsigned long)value);
+    }
+}
+
+void metrics_float(metrics_writer_t *w, const char *name, const char *labels, float value) {
+    if (labels) {
+        metrics_printf(w, "%s{%s} %.3f\n", name, labels, value);
+    } else {
+        metrics_printf(w, "%s %.3f\n", name, value);
+    }
+}
+
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value) {
+    // Índice da faixa: bits significativos de (value - 1) além de shift
+    unsigned i = 0;
+    uint32_t limite = value ? (value - 1) >> h->shift : 0;
+    while (limite) {
+        limite >>= 1;
+        i++;
+    }
+    if (i >= METRICS_HIST_BUCKETS) i = METRICS_HIST_BUCKETS - 1;
+
+    // A soma tem 64 bits, que o M0+ não grava de uma vez: o gerador não pode ver metade dela
+    uint32_t irq = save_and_disable_interrupts();
+    h->buckets[i]++;
+    h->sum += value;
+    restore_interrupts(irq);
+}
+
+void metrics_histogram_reset(metrics_histogram_t *h) {
+    uint32_t irq = save_and_disable_interrupts();
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) h->buckets[i] = 0;
+    h->sum = 0;
+    restore_interrupts(irq);
+}
+
+void metrics_histogram_snapshot(const metrics_histogram_t *h, metrics_histogram_t *out) {
+    uint32_t irq = save_and_disable_interrupts();
+    *out = *h;
+    restore_interrupts(irq);
+}
+
+void metrics_histogram_series(metrics_writer_t *w, const char *name, const char *labels, const metrics_histogram_t *h) {
+    metrics_histogram_t copia;
+    metrics_histogram_snapshot(h, &copia);
+
+    // O formato pede contagens acumuladas; _count é igual à faixa +Inf
+    const char *sep = labels ? "," : "";
+    if (!labels) labels = "";
+    uint32_t acumulado = 0;
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS; i++) {
+        acumulado += copia.buckets[i];
+        if (i < METRICS_HIST_BUCKETS - 1) {
+            metrics_printf(w, "%s_bucket{%s%sle=\"%lu\"} %lu\n", name, labels, sep, 1ul << (copia.shift + i), (unsigned long)acumulado);
+        } else {
+            metrics_printf(w, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", name, labels, sep, (unsigned long)acumulado);
+        }
+    }
+    if (*labels) {
+        metrics_printf(w, "%s_sum{%s} %llu\n%s_count{%s} %lu\n", name, labels, (unsigned long long)copia.sum, name, labels, (unsigned long)acumulado);
+    } else {
+        metrics_printf(w, "%s_sum %llu\n%s_count %lu\n", name, (unsigned long long)copia.sum, name, (unsigned long)acumulado);
+    }
+}
+
+void metrics_histogram(metrics_writer_t *w, const char *name, const char *help, const metrics_histogram_t *h) {
+    metrics_family(w, name, "histogram", help);
+    metrics_histogram_series(w, name, NULL, h);
+}
+
+bool metrics_register(metrics_collector_t collector, unsigned parts) {
+    if (num_coletores == METRICS_MAX_COLLECTORS) return false;
+    coletores[num_coletores] = collector;
+    partes[num_coletores] = parts;
+    num_coletores++;
+    return true;
+}
+
+bool metrics_collect(unsigned index, metrics_writer_t *w) {
+    for (unsigned i = 0; i < num_coletores; i++) {
+        if (index < partes[i]) {
+            coletores[i](w, index);
+            return true;
+        }
+        index -= partes[i];
+    }
+    return false;
+}
@@ -0,0 +1,69 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define METRICS_CHUNK_MAX 1400      // Texto gerado por uma parte de um coletor, enviado como um pedaço da resposta
+#define METRICS_MAX_COLLECTORS 12
+#define METRICS_HIST_BUCKETS 16     // Faixas de um histograma, a última sem limite (+Inf)
+
+/**
+ * Escrita de métricas no formato de texto do Prometheus em um buffer fixo. Se o texto não couber,
+ * a linha incompleta é descartada e overflow fica marcado; o que já foi escrito continua válido.
+ */
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+} metrics_writer_t;
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t size);
+
+// Linhas # HELP e # TYPE de uma família (type: "counter", "gauge" ou "histogram")
+void metrics_family(metrics_writer_t *w, const char *name, const char *type, const char *help);
+
+// Uma amostra. labels sem as chaves (por exemplo "canal=\"temp\"") ou NULL
+void metrics_uint(metrics_writer_t *w, const char *name, const char *labels, uint32_t value);
+void metrics_float(metrics_writer_t *w, const char *name, const char *labels, float value);
+
+/**
+ * Histograma de durações em µs com faixas em potências de 2: a faixa i conta valores até
+ * 2^(shift + i), a última conta o restante. Atualizado por um único contexto e lido pelo gerador de
+ * /metrics, que pode interrompê-lo.
+ */
+typedef struct {
+    uint8_t shift;
+    uint32_t buckets[METRICS_HIST_BUCKETS];
+    uint64_t sum;
+} metrics_histogram_t;
+
+#define METRICS_HISTOGRAM(shift) { (shift), { 0 }, 0 }
+
+void metrics_histogram_observe(metrics_histogram_t *h, uint32_t value);
+void metrics_histogram_reset(metrics_histogram_t *h);
+
+// Família completa do histograma: faixas acumuladas, _sum e _count
+void metrics_histogram(metrics_writer_t *w, const char *name, const char *help, const metrics_histogram_t *h);
+
+// Só as amostras de um histograma com labels, para famílias com várias séries (a família vem antes, com metrics_family)
+void metrics_histogram_series(metrics_writer_t *w, const char *name, const char *labels, const metrics_histogram_t *h);
+
+// Cópia consistente das faixas e da soma, para quem calcula sobre o histograma
+void metrics_histogram_snapshot(const metrics_histogram_t *h, metrics_histogram_t *out);
+
+/**
+ * Coletores escrevem suas famílias em partes de no máximo METRICS_CHUNK_MAX bytes cada (part vai de 0 a
+ * parts - 1). /metrics gera uma parte por vez, conforme há espaço na fila de envio, então o custo de
+ * cada passo é limitado.
+ */
+typedef void (*metrics_collector_t)(metrics_writer_t *w, unsigned part);
+
+bool metrics_register(metrics_collector_t collector, unsigned parts);
+
+// Gera a parte de número index, contando as partes de todos os coletores em ordem. Retorna false depois da última
+bool metrics_collect(unsigned index, metrics_writer_t *w);
+
+#endif // METRICS_H
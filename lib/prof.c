@@ -0,0 +1,113 @@
+#include <stdio.h>
+
+#include "metrics.h"
+#include "prof.h"
+
+#if PROF_ENABLED
+
+typedef struct {
+    const char *name;
+    uint8_t shift;   // Primeira faixa do histograma: até 2^shift µs
+} prof_stage_info_t;
+
+// As faixas cobrem de 2^shift a 2^(shift + 14) µs; etapas com espera na I2C começam mais alto
+static const prof_stage_info_t etapas[PROF_NUM_STAGES] = {
+    [PROF_BMP280]      = { "bmp280", 3 },
+    [PROF_COMPENSACAO] = { "compensacao", 1 },
+    [PROF_ALTITUDE]    = { "altitude", 1 },
+    [PROF_AHT20]       = { "aht20", 4 },
+    [PROF_LOG]         = { "log", 3 },
+    [PROF_PUBLICACAO]  = { "publicacao", 3 },
+    [PROF_ALARMES]     = { "alarmes", 1 },
+    [PROF_DISPLAY]     = { "display", 3 },
+    [PROF_OLED]        = { "oled", 1 },
+    [PROF_MATRIZ]      = { "matriz", 3 },
+};
+
+static metrics_histogram_t histogramas[PROF_NUM_STAGES];
+static uint32_t maximos[PROF_NUM_STAGES];
+
+// Uma parte de /metrics por etapa, mais uma com os máximos
+static void prof_collect(metrics_writer_t *w, unsigned part) {
+    char labels[24];
+
+    if (part < PROF_NUM_STAGES) {
+        if (part == 0) {
+            metrics_family(w, "station_stage_duration_us", "histogram", "Tempo de cada etapa do laco principal");
+        }
+        snprintf(labels, sizeof(labels), "etapa=\"%s\"", etapas[part].name);
+        metrics_histogram_series(w, "station_stage_duration_us", labels, &histogramas[part]);
+        return;
+    }
+
+    metrics_family(w, "station_stage_max_us", "gauge", "Maior tempo de cada etapa desde o ultimo reset");
+    for (unsigned i = 0; i < PROF_NUM_STAGES; i++) {
+        snprintf(labels, sizeof(labels), "etapa=\"%s\"", etapas[i].name);
+        metrics_uint(w, "station_stage_max_us", labels, maximos[i]);
+    }
+}
+
+void prof_init(void) {
+    for (unsigned i = 0; i < PROF_NUM_STAGES; i++) {
+        histogramas[i] = (metrics_histogram_t)METRICS_HISTOGRAM(etapas[i].shift);
+        maximos[i] = 0;
+    }
+    metrics_register(prof_collect, PROF_NUM_STAGES + 1);
+}
+
+void prof_record(prof_stage_t stage, uint32_t us) {
+    metrics_histogram_observe(&histogramas[stage], us);
+    if (us > maximos[stage]) maximos[stage] = us;
+}
+
+void prof_reset(void) {
+    for (unsigned i = 0; i < PROF_NUM_STAGES; i++) {
+        metrics_histogram_reset(&histogramas[i]);
+        maximos[i] = 0;
+    }
+}
+
+// Limite superior da faixa que contém a fração p das medidas; 0 na faixa sem limite
+static uint32_t prof_percentile(const metrics_histogram_t *h, uint32_t count, uint32_t p) {
+    uint32_t alvo = (uint32_t)(((uint64_t)count * p + 99) / 100);
+    uint32_t acumulado = 0;
+    for (unsigned i = 0; i < METRICS_HIST_BUCKETS - 1; i++) {
+        acumulado += h->buckets[i];
+        if (acumulado >= alvo) return 1ul << (h->shift + i);
+    }
+    return 0;
+}
+
+static void prof_bound(char *buf, size_t size, uint32_t bound) {
+    if (bound) {
+        snprintf(buf, size, "%lu", (unsigned long)bound);
+    } else {
+        snprintf(buf, size, "+Inf");
+    }
+}
+
+size_t prof_format(char *buf, size_t size) {
+    size_t n = snprintf(buf, size, "%-12s %8s %8s %8s %8s %8s (us)\n", "etapa", "n", "media", "max", "p50<=", "p99<=");
+
+    for (unsigned i = 0; i < PROF_NUM_STAGES && n < size; i++) {
+        metrics_histogram_t h;
+        metrics_histogram_snapshot(&histogramas[i], &h);
+
+        uint32_t count = 0;
+        for (unsigned b = 0; b < METRICS_HIST_BUCKETS; b++) count += h.buckets[b];
+        if (!count) {
+            n += snprintf(buf + n, size - n, "%-12s %8u\n", etapas[i].name, 0u);
+            continue;
+        }
+
+        char p50_txt[12], p99_txt[12];
+        prof_bound(p50_txt, sizeof(p50_txt), prof_percentile(&h, count, 50));
+        prof_bound(p99_txt, sizeof(p99_txt), prof_percentile(&h, count, 99));
+
+        n += snprintf(buf + n, size - n, "%-12s %8lu %8lu %8lu %8s %8s\n", etapas[i].name,
+                      (unsigned long)count, (unsigned long)(h.sum / count), (unsigned long)maximos[i], p50_txt, p99_txt);
+    }
+    return n < size ? n : size - 1;
+}
+
+#endif // PROF_ENABLED
@@ -0,0 +1,64 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Medição do tempo de cada etapa do laço principal em histogramas de µs (faixas em potências de 2).
+ * Com PROF_ENABLED 0, as sondas e as funções somem do código.
+ */
+#ifndef PROF_ENABLED
+#define PROF_ENABLED 0
+#endif
+
+typedef enum {
+    PROF_BMP280,        // Leitura I2C do BMP280
+    PROF_COMPENSACAO,   // Conversão dos valores brutos do BMP280
+    PROF_ALTITUDE,      // pow() da altitude
+    PROF_AHT20,         // Leitura I2C do AHT20, incluindo a espera da conversão
+    PROF_LOG,           // printf das medidas na USB
+    PROF_PUBLICACAO,    // Histórico e envio para /eventos e /ws
+    PROF_ALARMES,       // Limites, regras, LEDs e buzzer
+    PROF_DISPLAY,       // Formatação e desenho dos campos
+    PROF_OLED,          // Início do envio do quadro ao display
+    PROF_MATRIZ,        // Quadro da matriz de LEDs, no alarme de hardware
+    PROF_NUM_STAGES
+} prof_stage_t;
+
+#define PROF_TEXT_MAX ((PROF_NUM_STAGES + 1) * 72) // Tabela de prof_format
+
+#if PROF_ENABLED
+
+#include "pico/stdlib.h"
+
+void prof_init(void);
+void prof_record(prof_stage_t stage, uint32_t us);
+void prof_reset(void);
+
+// Tabela com contagem, média, máximo e percentis de cada etapa. Retorna o tamanho do texto
+size_t prof_format(char *buf, size_t size);
+
+/**
+ * Mede o bloco que segue: PROF_SCOPE(PROF_AHT20) { ... }. Um return ou break de dentro do bloco
+ * sai sem registrar a medida.
+ */
+#define PROF_SCOPE(stage) \
+    for (uint32_t prof_t0_ = time_us_32(), prof_once_ = 1; prof_once_; \
+         prof_once_ = 0, prof_record((stage), time_us_32() - prof_t0_))
+
+#else
+
+static inline void prof_init(void) {}
+static inline void prof_reset(void) {}
+static inline size_t prof_format(char *buf, size_t size) {
+    (void)buf;
+    (void)size;
+    return 0;
+}
+
+#define PROF_SCOPE(stage)
+
+#endif // PROF_ENABLED
+
+#endif // PROF_H
@@ -0,0 +1,234 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rules.h"
+#include "alarm.h"
+
+static const char *const nomes_canais[RULES_NUM_CHANNELS] = { "temp", "hum", "press" };
+static const char *const nomes_ops[] = { ">", "<", ">=", "<=" };
+
+void rules_init(rules_t *rules) {
+    memset(rules, 0, sizeof(*rules));
+    rules->next_id = 1;
+}
+
+void rules_clear(rules_t *rules) {
+    rules->num_rules = 0;
+    rules->num_conds = 0;
+}
+
+// Próxima palavra do texto: copia para token e retorna o ponteiro após ela, ou NULL no fim
+static const char *rules_token(const char *p, char *token, size_t size) {
+    while (*p == ' ') p++;
+    if (!*p) return NULL;
+
+    // Comparações formam palavras próprias, mesmo sem espaço: "temp>=30"
+    bool op = strchr("<>=", *p) != NULL;
+    size_t n = 0;
+    while (*p && *p != ' ' && (strchr("<>=", *p) != NULL) == op) {
+        if (n + 1 < size) token[n++] = *p;
+        p++;
+    }
+    token[n] = '\0';
+    return p;
+}
+
+static int rules_find(const char *const *nomes, size_t n, const char *token) {
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(nomes[i], token) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool rules_number(const char *token, float *out) {
+    char *fim;
+    *out = strtof(token, &fim);
+    // "nan", "inf" e números fora do alcance do float (1e40) não servem de limite
+    return fim != token && *fim == '\0' && isfinite(*out);
+}
+
+int rules_add(rules_t *rules, const char *text, const char **error) {
+    rules_rule_t regra = { .severity = ALARM_WARNING };
+    rules_cond_t conds[RULES_CONDS_PER_RULE];
+    char token[16];
+    const char *p = text;
+    const char *erro = NULL;
+
+    p = rules_token(p, token, sizeof(token));
+    if (p && strcmp(token, "crit") == 0) {
+        regra.severity = ALARM_CRITICAL;
+        p = rules_token(p, token, sizeof(token));
+    }
+
+    // Condições ligadas por "and"
+    while (!erro) {
+        if (regra.num_conds == RULES_CONDS_PER_RULE) { erro = "condicoes demais"; break; }
+        rules_cond_t *c = &conds[regra.num_conds];
+
+        int canal = p ? rules_find(nomes_canais, RULES_NUM_CHANNELS, token) : -1;
+        if (canal < 0) { erro = "canal esperado (temp, hum, press)"; break; }
+        c->source = (uint8_t)canal;
+
+        p = rules_token(p, token, sizeof(token));
+        if (p && strcmp(token, "rate") == 0) {
+            c->source |= RULES_SRC_RATE;
+            p = rules_token(p, token, sizeof(token));
+        }
+
+        int op = p ? rules_find(nomes_ops, 4, token) : -1;
+        if (op < 0) { erro = "comparacao esperada (>, <, >=, <=)"; break; }
+        c->op = (uint8_t)op;
+
+        p = rules_token(p, token, sizeof(token));
+        if (!p || !rules_number(token, &c->threshold)) { erro = "numero esperado"; break; }
+        regra.num_conds++;
+
+        p = rules_token(p, token, sizeof(token));
+        if (!p || strcmp(token, "and") != 0) break;
+        p = rules_token(p, token, sizeof(token));
+    }
+
+    if (!erro && p && strcmp(token, "for") == 0) {
+        float segundos;
+        p = rules_token(p, token, sizeof(token));
+        if (!p || !rules_number(token, &segundos) || segundos < 0 || segundos > 65535)
+            erro = "segundos esperados apos for";
+        else
+            regra.hold_s = (uint16_t)segundos;
+        if (!erro) p = rules_token(p, token, sizeof(token));
+    }
+
+    if (!erro && p) erro = "texto inesperado no fim da regra";
+    if (!erro && rules->num_rules == RULES_MAX) erro = "limite de regras atingido";
+    if (!erro && rules->num_conds + regra.num_conds > RULES_MAX_CONDS) erro = "limite de condicoes atingido";
+    if (erro) {
+        if (error) *error = erro;
+        return -1;
+    }
+
+    regra.id = rules->next_id++;
+    regra.first_cond = rules->num_conds;
+    memcpy(&rules->conds[rules->num_conds], conds, regra.num_conds * sizeof(rules_cond_t));
+    rules->num_conds += regra.num_conds;
+    rules->rules[rules->num_rules++] = regra;
+
+    // A forma normalizada (espaços nos operadores, %g) pode ser maior que o texto recebido.
+    // Quem lista as regras reserva RULES_TEXT_MAX por regra: acima disso, desfaz o acréscimo
+    char formatada[RULES_TEXT_MAX + 1];
+    if (rules_format(rules, &rules->rules[rules->num_rules - 1], formatada, sizeof(formatada)) >= RULES_TEXT_MAX) {
+        rules->num_rules--;
+        rules->num_conds -= regra.num_conds;
+        rules->next_id--;
+        if (error) *error = "regra longa demais";
+        return -1;
+    }
+    return regra.id;
+}
+
+bool rules_remove(rules_t *rules, uint16_t id) {
+    for (uint16_t i = 0; i < rules->num_rules; i++) {
+        rules_rule_t *r = &rules->rules[i];
+        if (r->id != id) continue;
+
+        // Remove as condições da regra e corrige o índice das regras seguintes
+        uint16_t inicio = r->first_cond, n = r->num_conds;
+        memmove(&rules->conds[inicio], &rules->conds[inicio + n],
+                (rules->num_conds - inicio - n) * sizeof(rules_cond_t));
+        rules->num_conds -= n;
+        memmove(r, r + 1, (rules->num_rules - i - 1) * sizeof(rules_rule_t));
+        rules->num_rules--;
+        for (uint16_t k = i; k < rules->num_rules; k++)
+            rules->rules[k].first_cond -= n;
+        return true;
+    }
+    return false;
+}
+
+// Guarda uma amostra por RULES_RATE_PERIOD_MS e calcula a variação por hora desde a mais antiga da janela
+static void rules_update_rate(rules_t *rules, const float values[RULES_NUM_CHANNELS], uint32_t now_ms) {
+    uint8_t ultimo = (rules->history_head + RULES_RATE_SLOTS - 1) % RULES_RATE_SLOTS;
+    if (rules->history_count == 0 || now_ms - rules->history_ms[ultimo] >= RULES_RATE_PERIOD_MS) {
+        memcpy(rules->history[rules->history_head], values, sizeof(rules->history[0]));
+        rules->history_ms[rules->history_head] = now_ms;
+        rules->history_head = (rules->history_head + 1) % RULES_RATE_SLOTS;
+        if (rules->history_count < RULES_RATE_SLOTS) rules->history_count++;
+    }
+
+    uint8_t antigo = (rules->history_head + RULES_RATE_SLOTS - rules->history_count) % RULES_RATE_SLOTS;
+    uint32_t dt = now_ms - rules->history_ms[antigo];
+
+    // Menos de um intervalo de histórico: condições de taxa ficam falsas
+    rules->rate_valid = dt >= RULES_RATE_PERIOD_MS;
+    if (!rules->rate_valid) return;
+
+    float horas = dt / 3600000.0f;
+    for (int k = 0; k < RULES_NUM_CHANNELS; k++)
+        rules->rate[k] = (values[k] - rules->history[antigo][k]) / horas;
+}
+
+static bool rules_cond_true(const rules_t *rules, const rules_cond_t *c, const float values[RULES_NUM_CHANNELS]) {
+    float v;
+    if (c->source & RULES_SRC_RATE) {
+        if (!rules->rate_valid) return false;
+        v = rules->rate[c->source & ~RULES_SRC_RATE];
+    } else {
+        v = values[c->source];
+    }
+
+    switch (c->op) {
+        case RULES_GT: return v > c->threshold;
+        case RULES_LT: return v < c->threshold;
+        case RULES_GE: return v >= c->threshold;
+        default:       return v <= c->threshold;
+    }
+}
+
+uint8_t rules_evaluate(rules_t *rules, const float values[RULES_NUM_CHANNELS], uint32_t now_ms) {
+    uint8_t severidade = ALARM_NONE;
+
+    rules_update_rate(rules, values, now_ms);
+
+    for (uint16_t i = 0; i < rules->num_rules; i++) {
+        rules_rule_t *r = &rules->rules[i];
+        const rules_cond_t *c = &rules->conds[r->first_cond];
+
+        bool verdadeira = true;
+        for (uint8_t k = 0; k < r->num_conds && verdadeira; k++)
+            verdadeira = rules_cond_true(rules, &c[k], values);
+
+        if (!verdadeira) {
+            r->since_ms = 0;
+            r->active = false;
+            continue;
+        }
+
+        if (r->since_ms == 0) r->since_ms = now_ms ? now_ms : 1;
+        r->active = (now_ms - r->since_ms) >= (uint32_t)r->hold_s * 1000u;
+        if (r->active && r->severity > severidade) severidade = r->severity;
+    }
+    return severidade;
+}
+
+size_t rules_format(const rules_t *rules, const rules_rule_t *rule, char *out, size_t size) {
+    size_t n = 0;
+    if (size == 0) return 0;
+    out[0] = '\0';
+
+#define RULES_APPEND(...) do { \
+        int w = snprintf(out + n, size - n, __VA_ARGS__); \
+        if (w > 0) n = (n + w < size) ? n + w : size - 1; \
+    } while (0)
+
+    if (rule->severity == ALARM_CRITICAL) RULES_APPEND("crit ");
+    for (uint8_t k = 0; k < rule->num_conds; k++) {
+        const rules_cond_t *c = &rules->conds[rule->first_cond + k];
+        RULES_APPEND("%s%s%s %s %g", k ? " and " : "", nomes_canais[c->source & ~RULES_SRC_RATE],
+                     (c->source & RULES_SRC_RATE) ? " rate" : "", nomes_ops[c->op], c->threshold);
+    }
+    if (rule->hold_s) RULES_APPEND(" for %u", rule->hold_s);
+
+#undef RULES_APPEND
+    return n;
+}
@@ -0,0 +1,97 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef RULES_MAX
+#define RULES_MAX 16            // Regras configuráveis
+#endif
+#define RULES_MAX_CONDS (RULES_MAX * 2)  // Condições somadas de todas as regras
+#define RULES_CONDS_PER_RULE 4
+#define RULES_TEXT_MAX 64       // Texto de uma regra formatada
+
+#define RULES_RATE_PERIOD_MS 60000  // Intervalo entre amostras guardadas para a taxa de variação
+#define RULES_RATE_SLOTS 11         // Janela da taxa: 10 intervalos (10 min)
+
+typedef enum {
+    RULES_TEMP,
+    RULES_HUM,
+    RULES_PRESS,
+    RULES_NUM_CHANNELS
+} rules_channel_t;
+
+typedef enum {
+    RULES_GT,
+    RULES_LT,
+    RULES_GE,
+    RULES_LE
+} rules_op_t;
+
+#define RULES_SRC_RATE 0x80  // Em rules_cond_t.source: taxa de variação por hora em vez do valor
+
+// Condição compilada: fonte (canal, com RULES_SRC_RATE para a taxa), comparação e limite
+typedef struct {
+    uint8_t source;
+    uint8_t op;
+    float threshold;
+} rules_cond_t;
+
+/**
+ * Regra compilada: conjunção das condições conds[first_cond .. first_cond + num_conds - 1],
+ * que precisa se manter verdadeira por hold_s segundos para ativar a regra.
+ */
+typedef struct {
+    uint16_t id;
+    uint16_t first_cond;
+    uint8_t num_conds;
+    uint8_t severity;       // alarm_severity_t da regra ativa
+    uint16_t hold_s;
+    bool active;
+    uint32_t since_ms;      // Início do período com as condições verdadeiras (0 = falsas)
+} rules_rule_t;
+
+/**
+ * Motor de regras de alarme. O texto de cada regra é compilado uma vez para uma tabela de
+ * condições; a avaliação percorre apenas a tabela, com custo limitado a RULES_MAX_CONDS
+ * comparações por amostra.
+ *
+ * Sintaxe (palavras separadas por espaço; as comparações dispensam o espaço):
+ *   [crit] <canal> [rate] <op> <número> [and <canal> [rate] <op> <número>]... [for <segundos>]
+ * com canal temp, hum ou press; op >, <, >= ou <=; "rate" compara a variação por hora.
+ * Exemplos: "temp > 30 for 60", "hum rate > 5", "crit temp > 35 and hum > 80".
+ */
+typedef struct {
+    rules_rule_t rules[RULES_MAX];
+    uint16_t num_rules;
+    rules_cond_t conds[RULES_MAX_CONDS];
+    uint16_t num_conds;
+    uint16_t next_id;
+
+    // Histórico para a taxa de variação
+    float history[RULES_RATE_SLOTS][RULES_NUM_CHANNELS];
+    uint32_t history_ms[RULES_RATE_SLOTS];
+    uint8_t history_head, history_count;
+    float rate[RULES_NUM_CHANNELS];   // Variação por hora na janela
+    bool rate_valid;
+} rules_t;
+
+void rules_init(rules_t *rules);
+
+/**
+ * Compila e acrescenta uma regra. Retorna o id da regra ou -1, com a descrição do erro em *error.
+ * Recusa regras cuja forma normalizada (rules_format) não caiba em RULES_TEXT_MAX, com o '\0'.
+ */
+int rules_add(rules_t *rules, const char *text, const char **error);
+
+bool rules_remove(rules_t *rules, uint16_t id);
+void rules_clear(rules_t *rules);
+
+// Avalia todas as regras com a amostra atual e retorna a maior severidade entre as regras ativas
+uint8_t rules_evaluate(rules_t *rules, const float values[RULES_NUM_CHANNELS], uint32_t now_ms);
+
+// Reconstrói o texto de uma regra a partir da forma compilada
+size_t rules_format(const rules_t *rules, const rules_rule_t *rule, char *out, size_t size);
+
+#endif // RULES_H
@@ -0,0 +1,118 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/i2c.h"
+
+#include "aht20.h"
+#include "bmp280.h"
+#include "sensor_trace.h"
+
+#if SENSOR_TRACE_ENABLED
+
+#define SENSOR_TRACE_BOOT_MAX 24 // Transações da inicialização, repetidas a cada conexão
+#define SENSOR_TRACE_FILA_MAX 64 // Transações do laço aguardando a USB (~30 amostras)
+
+typedef struct {
+    uint64_t t_us;
+    uint8_t addr;
+    char tipo;       // 'R' ou 'W'
+    int8_t ret;      // Retorno da função do SDK: bytes transferidos ou PICO_ERROR_*
+    uint8_t len;     // Bytes guardados em data
+    uint8_t data[SENSOR_TRACE_DATA_MAX];
+} sensor_trace_rec_t;
+
+// Só o laço principal usa a I2C dos sensores e chama sensor_trace_flush: não há concorrência
+static sensor_trace_rec_t boot[SENSOR_TRACE_BOOT_MAX];
+static uint8_t boot_len = 0;
+static bool no_laco = false;
+
+static sensor_trace_rec_t fila[SENSOR_TRACE_FILA_MAX];
+static uint16_t fila_inicio = 0, fila_len = 0;
+static uint32_t perdidas = 0;   // Transações descartadas com a fila cheia, ainda não avisadas
+static bool conectado = false;
+
+int __real_i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+int __real_i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+static void gravar(char tipo, uint8_t addr, const uint8_t *data, size_t len, int ret) {
+    if (addr != AHT20_I2C_ADDR && addr != ADDR) return; // Display e outros dispositivos ficam de fora
+
+    sensor_trace_rec_t *r;
+    if (!no_laco) {
+        if (boot_len == SENSOR_TRACE_BOOT_MAX) return;
+        r = &boot[boot_len++];
+    } else {
+        if (fila_len == SENSOR_TRACE_FILA_MAX) {
+            perdidas++;
+            return;
+        }
+        r = &fila[(fila_inicio + fila_len++) % SENSOR_TRACE_FILA_MAX];
+    }
+
+    r->t_us = time_us_64();
+    r->addr = addr;
+    r->tipo = tipo;
+    r->ret = ret;
+    r->len = len > SENSOR_TRACE_DATA_MAX ? SENSOR_TRACE_DATA_MAX : len;
+    // Numa leitura com erro o buffer não tem dados válidos
+    if (tipo == 'R' && ret < 0) r->len = 0;
+    memcpy(r->data, data, r->len);
+}
+
+int __wrap_i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    int ret = __real_i2c_read_blocking(i2c, addr, dst, len, nostop);
+    gravar('R', addr, dst, len, ret);
+    return ret;
+}
+
+int __wrap_i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    int ret = __real_i2c_write_blocking(i2c, addr, src, len, nostop);
+    gravar('W', addr, src, len, ret);
+    return ret;
+}
+
+static void imprimir(const sensor_trace_rec_t *r) {
+    char hex[2 * SENSOR_TRACE_DATA_MAX + 1];
+    for (int i = 0; i < r->len; i++) {
+        snprintf(hex + 2 * i, 3, "%02x", r->data[i]);
+    }
+    hex[2 * r->len] = '\0';
+    printf("#I2C %llu %c %02x %d %s\n", (unsigned long long)r->t_us, r->tipo, r->addr, r->ret, hex);
+}
+
+void sensor_trace_begin_loop(void) {
+    no_laco = true;
+}
+
+void sensor_trace_flush(void) {
+    // Sem terminal não há captura em andamento: o que está na fila não serviria a ninguém
+    if (!stdio_usb_connected()) {
+        conectado = false;
+        fila_len = 0;
+        perdidas = 0;
+        return;
+    }
+
+    // Nova conexão: reenvia a inicialização para a captura começar com a calibração
+    if (!conectado) {
+        conectado = true;
+        printf("#I2C boot\n");
+        for (int i = 0; i < boot_len; i++) imprimir(&boot[i]);
+        if (no_laco) printf("#I2C loop\n");
+    }
+
+    if (perdidas) {
+        printf("#I2C perdidos %lu\n", (unsigned long)perdidas);
+        perdidas = 0;
+    }
+    while (fila_len) {
+        imprimir(&fila[fila_inicio]);
+        fila_inicio = (fila_inicio + 1) % SENSOR_TRACE_FILA_MAX;
+        fila_len--;
+    }
+}
+
+#endif // SENSOR_TRACE_ENABLED
@@ -0,0 +1,37 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <stdint.h>
+
+/**
+ * Gravação das transações I2C do AHT20 e do BMP280 (respostas brutas, calibração incluída) para
+ * reprodução no computador com tools/replay. O embrulho de i2c_read_blocking e i2c_write_blocking
+ * vem do link (opção STATION_TRACE do CMake); com SENSOR_TRACE_ENABLED 0 tudo some do código.
+ *
+ * Cada transação vira uma linha na USB:
+ *   #I2C <t_us> <R|W> <endereço> <retorno> <bytes em hex>
+ * As transações da inicialização ficam guardadas e são repetidas, entre "#I2C boot" e "#I2C loop",
+ * sempre que um terminal se conecta à USB, para que qualquer captura comece com a calibração.
+ */
+#ifndef SENSOR_TRACE_ENABLED
+#define SENSOR_TRACE_ENABLED 0
+#endif
+
+#define SENSOR_TRACE_DATA_MAX 24 // Maior transação gravada: os parâmetros de calibração do BMP280
+
+#if SENSOR_TRACE_ENABLED
+
+// Marca o fim da inicialização dos sensores: daqui em diante as transações são do laço principal
+void sensor_trace_begin_loop(void);
+
+// Envia as transações pendentes pela USB. Chamada pelo laço principal
+void sensor_trace_flush(void);
+
+#else
+
+static inline void sensor_trace_begin_loop(void) {}
+static inline void sensor_trace_flush(void) {}
+
+#endif // SENSOR_TRACE_ENABLED
+
+#endif // SENSOR_TRACE_H
@@ -0,0 +1,26 @@
+#include <string.h>
+
+#include "hardware/sync.h"
+#include "seqlatch.h"
+
+void seqlatch_publish(seqlatch_t *latch, const void *value) {
+    latch->seq++;     // Ímpar: leitores passam para copy[1]
+    __dmb();
+    memcpy(latch->copy[0], value, latch->size);
+    __dmb();
+    latch->seq++;     // Par: leitores voltam para copy[0], já atualizada
+    __dmb();
+    memcpy(latch->copy[1], value, latch->size);
+    __dmb();
+}
+
+uint32_t seqlatch_read(const seqlatch_t *latch, void *out) {
+    uint32_t seq;
+    do {
+        seq = latch->seq;
+        __dmb();
+        memcpy(out, latch->copy[seq & 1], latch->size);
+        __dmb();
+    } while (seq != latch->seq);
+    return seq >> 1;
+}
@@ -0,0 +1,29 @@
+#ifndef SEQLATCH_H
+#define SEQLATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Publicação de um valor por um único escritor para leitores que não podem bloquear (por exemplo,
+ * callbacks do lwIP que interrompem o laço principal). O valor tem duas cópias: enquanto o escritor
+ * grava uma, os leitores leem a outra, escolhida pela paridade do contador de sequência. O leitor
+ * só repete a cópia se o escritor tiver avançado durante a leitura, o que não ocorre quando ele
+ * interrompe o escritor no mesmo núcleo.
+ */
+typedef struct {
+    volatile uint32_t seq;  // Par: leitores usam copy[0]; ímpar: copy[1]
+    void *copy[2];
+    size_t size;
+} seqlatch_t;
+
+// As duas cópias devem começar com o mesmo conteúdo (por exemplo, ambas zeradas)
+#define SEQLATCH_INIT(copy0, copy1, size) { 0, { (copy0), (copy1) }, (size) }
+
+// Publica um novo valor. Apenas um escritor
+void seqlatch_publish(seqlatch_t *latch, const void *value);
+
+// Copia o último valor publicado para out e retorna quantas publicações já ocorreram
+uint32_t seqlatch_read(const seqlatch_t *latch, void *out);
+
+#endif // SEQLATCH_H
@@ -0,0 +1,21 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA1_DIGEST_SIZE 20
+
+// Estado do SHA-1 (FIPS 180-4). Usado no handshake do WebSocket
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;    // Total de bytes processados
+    uint8_t block[64];  // Bloco parcial ainda não processado
+    size_t block_len;
+} sha1_ctx_t;
+
+void sha1_init(sha1_ctx_t *ctx);
+void sha1_update(sha1_ctx_t *ctx, const void *data, size_t len);
+void sha1_final(sha1_ctx_t *ctx, uint8_t digest[SHA1_DIGEST_SIZE]);
+
+#endif // SHA1_H
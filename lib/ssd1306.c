@@ -1,5 +1,28 @@
+#include <string.h>
+
 #include "ssd1306.h"
 #include "font.h"
+#include "hardware/dma.h"
+
+// Custo fixo de uma janela na I2C: endereço, 6 pares (controle 0x80, comando) e o controle dos dados
+#define SSD1306_WINDOW_OVERHEAD (1 + 6 * 2 + 1)
+
+// Palavras de IC_DATA_CMD de um quadro completo: 6 pares de comando + controle dos dados + framebuffer.
+// Um quadro parcial só é montado quando custa menos que o completo, então cabe no mesmo espaço
+#define SSD1306_STREAM_WORDS(bufsize) (6 * 2 + (bufsize))
+
+// Nova consulta enquanto a DMA termina um quadro (um quadro completo leva ~25 ms a 400 kHz)
+#define SSD1306_BUSY_POLL_US 1000
+
+static inline void ssd1306_mark_dirty(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1) {
+  if (x0 < ssd->dirty_min[page]) ssd->dirty_min[page] = x0;
+  if (x1 > ssd->dirty_max[page]) ssd->dirty_max[page] = x1;
+}
+
+static inline void ssd1306_clear_dirty(ssd1306_t *ssd, uint8_t page) {
+  ssd->dirty_min[page] = 0xFF;
+  ssd->dirty_max[page] = 0;
+}
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
   ssd->width = width;
@@ -11,37 +34,56 @@ void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_v
   ssd->ram_buffer = calloc(ssd->bufsize, sizeof(uint8_t));
   ssd->ram_buffer[0] = 0x40;
   ssd->port_buffer[0] = 0x80;
+  ssd->front_buffer = calloc(ssd->bufsize - 1, sizeof(uint8_t));
+  ssd->tx_stream = calloc(SSD1306_STREAM_WORDS(ssd->bufsize), sizeof(uint16_t));
+
+  // DMA alimenta o FIFO de transmissão da I2C no ritmo do DREQ, uma palavra de IC_DATA_CMD por vez
+  ssd->dma_chan = dma_claim_unused_channel(true);
+  dma_channel_config cfg = dma_channel_get_default_config(ssd->dma_chan);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, true);
+  channel_config_set_write_increment(&cfg, false);
+  channel_config_set_dreq(&cfg, i2c_get_dreq(i2c, true));
+  dma_channel_configure(ssd->dma_chan, &cfg, &i2c_get_hw(i2c)->data_cmd, ssd->tx_stream, 0, false);
+  ssd->tx_active = false;
+  ssd->frame_interval_us = 0;
+  ssd->last_frame_us = 0;
+
+  // A RAM do display tem conteúdo aleatório ao ligar: o primeiro envio é completo
+  for (uint8_t page = 0; page < ssd->pages; ++page) {
+    ssd1306_clear_dirty(ssd, page);
+    ssd1306_mark_dirty(ssd, page, 0, ssd->width - 1);
+  }
+  ssd->full_refresh = true;
+  ssd->tx_bytes = 0;
+  ssd->tx_us = 0;
 }
 
 void ssd1306_config(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_DISP | 0x00);
-  ssd1306_command(ssd, SET_MEM_ADDR);
-  ssd1306_command(ssd, 0x01);
-  ssd1306_command(ssd, SET_DISP_START_LINE | 0x00);
-  ssd1306_command(ssd, SET_SEG_REMAP | 0x01);
-  ssd1306_command(ssd, SET_MUX_RATIO);
-  ssd1306_command(ssd, HEIGHT - 1);
-  ssd1306_command(ssd, SET_COM_OUT_DIR | 0x08);
-  ssd1306_command(ssd, SET_DISP_OFFSET);
-  ssd1306_command(ssd, 0x00);
-  ssd1306_command(ssd, SET_COM_PIN_CFG);
-  ssd1306_command(ssd, 0x12);
-  ssd1306_command(ssd, SET_DISP_CLK_DIV);
-  ssd1306_command(ssd, 0x80);
-  ssd1306_command(ssd, SET_PRECHARGE);
-  ssd1306_command(ssd, 0xF1);
-  ssd1306_command(ssd, SET_VCOM_DESEL);
-  ssd1306_command(ssd, 0x30);
-  ssd1306_command(ssd, SET_CONTRAST);
-  ssd1306_command(ssd, 0xFF);
-  ssd1306_command(ssd, SET_ENTIRE_ON);
-  ssd1306_command(ssd, SET_NORM_INV);
-  ssd1306_command(ssd, SET_CHARGE_PUMP);
-  ssd1306_command(ssd, 0x14);
-  ssd1306_command(ssd, SET_DISP | 0x01);
+  // Sequência de inicialização enviada numa única transação I2C
+  static const uint8_t config[] = {
+    SET_DISP | 0x00,
+    SET_MEM_ADDR, 0x00, // Endereçamento horizontal: cada página é uma faixa contígua do framebuffer
+    SET_DISP_START_LINE | 0x00,
+    SET_SEG_REMAP | 0x01,
+    SET_MUX_RATIO, HEIGHT - 1,
+    SET_COM_OUT_DIR | 0x08,
+    SET_DISP_OFFSET, 0x00,
+    SET_COM_PIN_CFG, 0x12,
+    SET_DISP_CLK_DIV, 0x80,
+    SET_PRECHARGE, 0xF1,
+    SET_VCOM_DESEL, 0x30,
+    SET_CONTRAST, 0xFF,
+    SET_ENTIRE_ON,
+    SET_NORM_INV,
+    SET_CHARGE_PUMP, 0x14,
+    SET_DISP | 0x01
+  };
+  ssd1306_command_list(ssd, config, sizeof(config));
 }
 
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
+  ssd1306_wait(ssd); // Não intercala com um quadro em transmissão pela DMA
   ssd->port_buffer[1] = command;
   i2c_write_blocking(
     ssd->i2c_port,
@@ -52,69 +94,301 @@ void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   );
 }
 
+/**
+ * Envia uma sequência de comandos numa única transação: o byte de controle 0x00 (Co = 0)
+ * indica que todos os bytes seguintes são comandos.
+ */
+void ssd1306_command_list(ssd1306_t *ssd, const uint8_t *commands, size_t len) {
+  uint8_t buffer[SSD1306_COMMAND_LIST_MAX + 1];
+
+  if (len > SSD1306_COMMAND_LIST_MAX)
+    len = SSD1306_COMMAND_LIST_MAX;
+  buffer[0] = 0x00;
+  memcpy(buffer + 1, commands, len);
+
+  ssd1306_wait(ssd);
+  i2c_write_blocking(ssd->i2c_port, ssd->address, buffer, len + 1, false);
+}
+
+void ssd1306_set_frame_rate(ssd1306_t *ssd, uint8_t fps) {
+  ssd->frame_interval_us = fps ? 1000000u / fps : 0;
+}
+
+/**
+ * Indica se ainda há um quadro sendo transmitido. Ao terminar, verifica se a transferência
+ * foi abortada (sem ACK do display); nesse caso o conteúdo do display passa a ser desconhecido.
+ */
+bool ssd1306_busy(ssd1306_t *ssd) {
+  if (!ssd->tx_active)
+    return false;
+
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  if (dma_channel_is_busy(ssd->dma_chan) ||
+      !(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+      (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS))
+    return true;
+
+  if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+    (void)hw->clr_tx_abrt;
+    ssd->full_refresh = true;
+    for (uint8_t page = 0; page < ssd->pages; ++page)
+      ssd1306_mark_dirty(ssd, page, 0, ssd->width - 1);
+  }
+  ssd->tx_active = false;
+  return false;
+}
+
+void ssd1306_wait(ssd1306_t *ssd) {
+  while (ssd1306_busy(ssd))
+    tight_loop_contents();
+}
+
+/**
+ * Acrescenta à sequência da DMA uma transação com a janela e os dados: os comandos de endereçamento
+ * vão como pares com Co = 1 (controle 0x80) e o controle 0x40 passa o restante da transação para dados.
+ * Os bytes vêm do back buffer e são copiados para o front buffer.
+ */
+static uint16_t *ssd1306_stream_window(ssd1306_t *ssd, uint16_t *p, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+  const uint8_t window[] = { SET_COL_ADDR, x0, x1, SET_PAGE_ADDR, page0, page1 };
+  size_t offset = page0 * ssd->width + x0;
+  size_t len = (page1 - page0 + 1) * ssd->width - x0 - (ssd->width - 1 - x1);
+  const uint8_t *data = ssd->ram_buffer + 1 + offset;
+
+  for (size_t i = 0; i < sizeof(window); ++i) {
+    *p++ = 0x80;
+    *p++ = window[i];
+  }
+  *p++ = 0x40;
+  for (size_t i = 0; i < len; ++i)
+    *p++ = data[i];
+  p[-1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+  memcpy(ssd->front_buffer + offset, data, len);
+  ssd->tx_bytes += SSD1306_WINDOW_OVERHEAD + len;
+  return p;
+}
+
+/**
+ * Monta a sequência do quadro e inicia a DMA para o FIFO da I2C. Apenas as janelas alteradas de
+ * cada página entram no quadro; quando somadas custariam mais que o quadro inteiro, ele vai completo.
+ * Retorna false se não havia nada a enviar.
+ */
+static bool ssd1306_start_frame(ssd1306_t *ssd) {
+  uint8_t x0[SSD1306_MAX_PAGES], x1[SSD1306_MAX_PAGES];
+  size_t custo = 0;
+
+  for (uint8_t page = 0; page < ssd->pages; ++page) {
+    uint8_t a = ssd->dirty_min[page], b = ssd->dirty_max[page];
+    ssd1306_clear_dirty(ssd, page);
+
+    // Descarta das bordas da janela os bytes que já estão iguais no display
+    if (a <= b && !ssd->full_refresh) {
+      const uint8_t *atual = ssd->ram_buffer + 1 + page * ssd->width;
+      const uint8_t *enviado = ssd->front_buffer + page * ssd->width;
+      while (a <= b && atual[a] == enviado[a]) a++;
+      while (b > a && atual[b] == enviado[b]) b--;
+    }
+
+    x0[page] = a;
+    x1[page] = b;
+    if (a <= b) custo += SSD1306_WINDOW_OVERHEAD + (b - a + 1);
+  }
+
+  ssd->tx_bytes = 0;
+  if (custo == 0)
+    return false;
+
+  uint16_t *p = ssd->tx_stream;
+  if (custo >= SSD1306_WINDOW_OVERHEAD + ssd->bufsize - 1) {
+    p = ssd1306_stream_window(ssd, p, 0, ssd->width - 1, 0, ssd->pages - 1);
+  } else {
+    for (uint8_t page = 0; page < ssd->pages; ++page) {
+      if (x0[page] > x1[page])
+        continue;
+      p = ssd1306_stream_window(ssd, p, x0[page], x1[page], page, page);
+    }
+  }
+  ssd->full_refresh = false;
+
+  // Mesmo procedimento de i2c_write_blocking para selecionar o endereço do display
+  i2c_hw_t *hw = i2c_get_hw(ssd->i2c_port);
+  hw->enable = 0;
+  hw->tar = ssd->address;
+  hw->enable = 1;
+
+  ssd->tx_active = true;
+  dma_channel_transfer_from_buffer_now(ssd->dma_chan, ssd->tx_stream, p - ssd->tx_stream);
+  return true;
+}
+
+/**
+ * Envia o quadro sem bloquear: o back buffer (ram_buffer) pode ser redesenhado logo em seguida.
+ * Retorna false, mantendo as alterações pendentes para a próxima chamada, se o quadro anterior
+ * ainda está em transmissão ou se o intervalo mínimo entre quadros não passou.
+ */
+bool ssd1306_send_data_async(ssd1306_t *ssd) {
+  uint32_t inicio = time_us_32();
+
+  if (ssd1306_busy(ssd) || inicio - ssd->last_frame_us < ssd->frame_interval_us)
+    return false;
+
+  if (ssd1306_start_frame(ssd))
+    ssd->last_frame_us = inicio;
+  ssd->tx_us = time_us_32() - inicio;
+  return true;
+}
+
+bool ssd1306_pending(ssd1306_t *ssd) {
+  for (uint8_t page = 0; page < ssd->pages; ++page) {
+    if (ssd->dirty_min[page] <= ssd->dirty_max[page])
+      return true;
+  }
+  return false;
+}
+
+// Limite de quadros primeiro; se ele já passou e a DMA ainda transmite, uma nova consulta em breve
+uint32_t ssd1306_frame_wait_us(ssd1306_t *ssd) {
+  int32_t resta = (int32_t)(ssd->last_frame_us + ssd->frame_interval_us - time_us_32());
+  if (resta > 0)
+    return resta;
+  return ssd1306_busy(ssd) ? SSD1306_BUSY_POLL_US : 0;
+}
+
+// Envia o quadro e espera a transmissão terminar (inicialização e telas fora do laço principal)
 void ssd1306_send_data(ssd1306_t *ssd) {
-  ssd1306_command(ssd, SET_COL_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->width - 1);
-  ssd1306_command(ssd, SET_PAGE_ADDR);
-  ssd1306_command(ssd, 0);
-  ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  uint32_t inicio = time_us_32();
+
+  ssd1306_wait(ssd);
+  if (ssd1306_start_frame(ssd))
+    ssd->last_frame_us = inicio;
+  ssd1306_wait(ssd);
+  ssd->tx_us = time_us_32() - inicio;
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
-  uint16_t index = (y >> 3) + (x << 3) + 1;
+  uint8_t page = y >> 3;
+  uint16_t index = page * ssd->width + x + 1;
   uint8_t pixel = (y & 0b111);
-  if (value)
-    ssd->ram_buffer[index] |= (1 << pixel);
-  else
-    ssd->ram_buffer[index] &= ~(1 << pixel);
+  uint8_t old = ssd->ram_buffer[index];
+  uint8_t byte = value ? (old | (1 << pixel)) : (old & ~(1 << pixel));
+  if (byte != old) {
+    ssd->ram_buffer[index] = byte;
+    ssd1306_mark_dirty(ssd, page, x, x);
+  }
 }
 
-/*
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-  uint8_t byte = value ? 0xFF : 0x00;
-  for (uint8_t i = 1; i < ssd->bufsize; ++i)
-    ssd->ram_buffer[i] = byte;
-}*/
+// Máscara dos bits da página cobertos pelas linhas y0..y1
+static inline uint8_t ssd1306_page_mask(uint8_t page, uint8_t y0, uint8_t y1) {
+  uint8_t lo = (y0 > page * 8) ? (y0 & 7) : 0;
+  uint8_t hi = (y1 < page * 8 + 7) ? (y1 & 7) : 7;
+  return (uint8_t)((0xFF << lo) & (0xFF >> (7 - hi)));
+}
 
-void ssd1306_fill(ssd1306_t *ssd, bool value) {
-    // Itera por todas as posições do display
-    for (uint8_t y = 0; y < ssd->height; ++y) {
-        for (uint8_t x = 0; x < ssd->width; ++x) {
-            ssd1306_pixel(ssd, x, y, value);
-        }
+// Escreve os bits de mask nas colunas x0..x1 de uma página, marcando como sujas apenas as que mudaram
+static void ssd1306_blit_span(ssd1306_t *ssd, uint8_t page, uint8_t x0, uint8_t x1, uint8_t bits, uint8_t mask) {
+  uint8_t *row = ssd->ram_buffer + 1 + page * ssd->width;
+  int16_t first = -1, last = -1;
+
+  for (uint8_t x = x0; x <= x1; ++x) {
+    uint8_t byte = (row[x] & ~mask) | (bits & mask);
+    if (byte != row[x]) {
+      row[x] = byte;
+      if (first < 0) first = x;
+      last = x;
     }
+  }
+  if (first >= 0)
+    ssd1306_mark_dirty(ssd, page, first, last);
 }
 
+/**
+ * Escreve uma coluna de 8 pixels a partir da linha y. Alinhada à página, vira um único byte;
+ * caso contrário, é deslocada e dividida entre a página de y e a seguinte.
+ */
+static void ssd1306_blit_column(ssd1306_t *ssd, uint8_t x, uint8_t y, uint8_t bits, uint8_t mask) {
+  if (x >= ssd->width || y >= ssd->height)
+    return;
 
+  uint8_t page = y >> 3;
+  uint8_t shift = y & 7;
+  ssd1306_blit_span(ssd, page, x, x, bits << shift, mask << shift);
+  if (shift && page + 1 < ssd->pages)
+    ssd1306_blit_span(ssd, page + 1, x, x, bits >> (8 - shift), mask >> (8 - shift));
+}
 
-void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
-  for (uint8_t x = left; x < left + width; ++x) {
-    ssd1306_pixel(ssd, x, top, value);
-    ssd1306_pixel(ssd, x, top + height - 1, value);
-  }
-  for (uint8_t y = top; y < top + height; ++y) {
-    ssd1306_pixel(ssd, left, y, value);
-    ssd1306_pixel(ssd, left + width - 1, y, value);
-  }
+// Preenche o retângulo x0..x1, y0..y1 (inclusivos) página a página, recortado à tela
+static void ssd1306_blit_area(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1, bool value) {
+  if (x0 >= ssd->width || y0 >= ssd->height || x0 > x1 || y0 > y1)
+    return;
+  if (x1 >= ssd->width) x1 = ssd->width - 1;
+  if (y1 >= ssd->height) y1 = ssd->height - 1;
 
-  if (fill) {
-    for (uint8_t x = left + 1; x < left + width - 1; ++x) {
-      for (uint8_t y = top + 1; y < top + height - 1; ++y) {
-        ssd1306_pixel(ssd, x, y, value);
+  uint8_t bits = value ? 0xFF : 0x00;
+  for (uint8_t page = y0 >> 3; page <= (y1 >> 3); ++page)
+    ssd1306_blit_span(ssd, page, x0, x1, bits, ssd1306_page_mask(page, y0, y1));
+}
+
+/**
+ * Desloca uma coluna para a esquerda os pixels da área x0..x1, y0..y1 (a coluna x0 é descartada
+ * e a coluna x1 fica como estava). Bits das páginas fora de y0..y1 não são alterados.
+ */
+void ssd1306_scroll_left(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1) {
+  if (x1 >= ssd->width) x1 = ssd->width - 1;
+  if (y1 >= ssd->height) y1 = ssd->height - 1;
+  if (x0 >= x1 || y0 > y1)
+    return;
+
+  for (uint8_t page = y0 >> 3; page <= (y1 >> 3); ++page) {
+    uint8_t mask = ssd1306_page_mask(page, y0, y1);
+    uint8_t *row = ssd->ram_buffer + 1 + page * ssd->width;
+    int16_t first = -1, last = -1;
+
+    for (uint8_t x = x0; x < x1; ++x) {
+      uint8_t byte = (row[x] & ~mask) | (row[x + 1] & mask);
+      if (byte != row[x]) {
+        row[x] = byte;
+        if (first < 0) first = x;
+        last = x;
       }
     }
+    if (first >= 0)
+      ssd1306_mark_dirty(ssd, page, first, last);
+  }
+}
+
+void ssd1306_fill(ssd1306_t *ssd, bool value) {
+  ssd1306_blit_area(ssd, 0, ssd->width - 1, 0, ssd->height - 1, value);
+}
+
+void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+  if (width == 0 || height == 0)
+    return;
+
+  uint8_t right = left + width - 1;
+  uint8_t bottom = top + height - 1;
+
+  // Borda e interior têm a mesma cor: preenchido, é uma única área
+  if (fill) {
+    ssd1306_blit_area(ssd, left, right, top, bottom, value);
+    return;
   }
+  ssd1306_hline(ssd, left, right, top, value);
+  ssd1306_hline(ssd, left, right, bottom, value);
+  ssd1306_vline(ssd, left, top, bottom, value);
+  ssd1306_vline(ssd, right, top, bottom, value);
 }
 
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    // Linhas horizontais e verticais são escritas byte a byte
+    if (y0 == y1) {
+        ssd1306_hline(ssd, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, y0, value);
+        return;
+    }
+    if (x0 == x1) {
+        ssd1306_vline(ssd, x0, y0 < y1 ? y0 : y1, y0 < y1 ? y1 : y0, value);
+        return;
+    }
+
     int dx = abs(x1 - x0);
     int dy = abs(y1 - y0);
 
@@ -144,13 +418,11 @@ void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1
 
 
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
-  for (uint8_t x = x0; x <= x1; ++x)
-    ssd1306_pixel(ssd, x, y, value);
+  ssd1306_blit_area(ssd, x0, x1, y, y, value);
 }
 
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
-  for (uint8_t y = y0; y <= y1; ++y)
-    ssd1306_pixel(ssd, x, y, value);
+  ssd1306_blit_area(ssd, x, x, y0, y1, value);
 }
 
 // Função para desenhar um caractere
@@ -169,14 +441,10 @@ void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y)
     index = 0; // Índice 0 corresponde ao caractere "nada" (espaço)
   }
 
-  // Desenha o caractere na tela
+  // Cada byte da fonte é uma coluna de 8 pixels, no mesmo formato de um byte de página do display
   for (uint8_t i = 0; i < 8; ++i)
   {
-    uint8_t line = font[index + i]; // Acessa a linha correspondente do caractere na fonte
-    for (uint8_t j = 0; j < 8; ++j)
-    {
-      ssd1306_pixel(ssd, x + i, y + j, line & (1 << j)); // Desenha cada pixel do caractere
-    }
+    ssd1306_blit_column(ssd, x + i, y, font[index + i], 0xFF);
   }
 }
 
@@ -1,9 +1,14 @@
+#ifndef SSD1306_H
+#define SSD1306_H
+
 #include <stdlib.h>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 
 #define WIDTH 128
 #define HEIGHT 64
+#define SSD1306_MAX_PAGES 8
+#define SSD1306_COMMAND_LIST_MAX 32 // Comandos por transação em ssd1306_command_list
 
 typedef enum {
   SET_CONTRAST = 0x81,
@@ -29,15 +34,33 @@ typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t *i2c_port;
   bool external_vcc;
-  uint8_t *ram_buffer;
+  uint8_t *ram_buffer;   // Back buffer: byte de controle 0x40 seguido do framebuffer, página a página
   size_t bufsize;
   uint8_t port_buffer[2];
+  uint8_t *front_buffer; // Front buffer: conteúdo da RAM do display após o último quadro iniciado
+  uint16_t *tx_stream;   // Palavras de IC_DATA_CMD do quadro em transmissão, lidas pela DMA
+  int dma_chan;
+  volatile bool tx_active;
+  uint32_t frame_interval_us; // Intervalo mínimo entre quadros assíncronos (0 = sem limite)
+  uint32_t last_frame_us;
+  uint8_t dirty_min[SSD1306_MAX_PAGES]; // Colunas alteradas em cada página desde o último envio.
+  uint8_t dirty_max[SSD1306_MAX_PAGES]; // Página limpa quando dirty_min > dirty_max
+  bool full_refresh;     // Conteúdo do display desconhecido: o próximo envio não compara com front_buffer
+  uint32_t tx_bytes;     // Bytes transmitidos na I2C pelo último quadro
+  uint32_t tx_us;        // Tempo de CPU gasto no último envio (inclui a espera, no envio síncrono)
 } ssd1306_t;
 
 void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
+void ssd1306_command_list(ssd1306_t *ssd, const uint8_t *commands, size_t len);
 void ssd1306_send_data(ssd1306_t *ssd);
+bool ssd1306_send_data_async(ssd1306_t *ssd);
+bool ssd1306_busy(ssd1306_t *ssd);
+void ssd1306_wait(ssd1306_t *ssd);
+void ssd1306_set_frame_rate(ssd1306_t *ssd, uint8_t fps);
+bool ssd1306_pending(ssd1306_t *ssd);       // Há regiões alteradas ainda não enviadas
+uint32_t ssd1306_frame_wait_us(ssd1306_t *ssd); // Tempo até ssd1306_send_data_async aceitar um quadro
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value);
 void ssd1306_fill(ssd1306_t *ssd, bool value);
@@ -45,5 +68,8 @@ void ssd1306_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint
 void ssd1306_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value);
 void ssd1306_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value);
 void ssd1306_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value);
+void ssd1306_scroll_left(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y0, uint8_t y1);
 void ssd1306_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y);
-void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
\ No newline at end of file
+void ssd1306_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y);
+
+#endif // SSD1306_H
@@ -0,0 +1,156 @@
+#include <math.h>
+#include <string.h>
+
+#include "ui.h"
+
+static inline uint8_t ui_sparkline_width(const ui_sparkline_t *chart) {
+    uint8_t width = chart->x1 - chart->x0 + 1;
+    return width < UI_SPARK_MAX ? width : UI_SPARK_MAX;
+}
+
+// Amostra i, da mais antiga (0) à mais nova (count - 1)
+static inline float ui_sparkline_value(const ui_sparkline_t *chart, uint8_t i) {
+    uint8_t width = ui_sparkline_width(chart);
+    return chart->values[(chart->head + width - chart->count + i) % width];
+}
+
+// Linha do gráfico correspondente ao valor
+static uint8_t ui_sparkline_y(const ui_sparkline_t *chart, float value) {
+    float t = (value - chart->lo) / (chart->hi - chart->lo);
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return chart->y1 - (uint8_t)(t * (chart->y1 - chart->y0) + 0.5f);
+}
+
+// Desenha a coluna x ligando o valor anterior ao atual
+static void ui_sparkline_column(ui_t *ui, const ui_sparkline_t *chart, uint8_t x, uint8_t i) {
+    uint8_t y = ui_sparkline_y(chart, ui_sparkline_value(chart, i));
+    uint8_t y_ant = i ? ui_sparkline_y(chart, ui_sparkline_value(chart, i - 1)) : y;
+    ssd1306_vline(ui->ssd, x, y < y_ant ? y : y_ant, y < y_ant ? y_ant : y, true);
+}
+
+// Redesenha o gráfico inteiro
+static void ui_sparkline_draw(ui_t *ui, const ui_sparkline_t *chart) {
+    ssd1306_rect(ui->ssd, chart->y0, chart->x0, chart->x1 - chart->x0 + 1, chart->y1 - chart->y0 + 1, false, true);
+    for (uint8_t i = 0; i < chart->count; ++i)
+        ui_sparkline_column(ui, chart, chart->x1 - (chart->count - 1 - i), i);
+}
+
+// Recalcula a escala arredondada. Retorna true se ela mudou
+static bool ui_sparkline_rescale(ui_sparkline_t *chart) {
+    float min = ui_sparkline_value(chart, 0), max = min;
+    for (uint8_t i = 1; i < chart->count; ++i) {
+        float v = ui_sparkline_value(chart, i);
+        if (v < min) min = v;
+        if (v > max) max = v;
+    }
+
+    float lo = floorf(min / chart->step) * chart->step;
+    float hi = ceilf(max / chart->step) * chart->step;
+    if (hi <= lo)
+        hi = lo + chart->step;
+
+    if (lo == chart->lo && hi == chart->hi)
+        return false;
+    chart->lo = lo;
+    chart->hi = hi;
+    return true;
+}
+
+void ui_init(ui_t *ui, ssd1306_t *ssd) {
+    ui->ssd = ssd;
+    ui->screen = NULL;
+    ui->chars_drawn = 0;
+}
+
+void ui_invalidate(ui_t *ui) {
+    ui->screen = NULL;
+}
+
+void ui_show(ui_t *ui, const ui_screen_t *screen) {
+    if (ui->screen == screen)
+        return;
+
+    ssd1306_t *ssd = ui->ssd;
+    ui->screen = screen;
+
+    ssd1306_fill(ssd, false);
+    if (screen->border)
+        ssd1306_rect(ssd, 3, 3, ssd->width - 6, ssd->height - 4, true, false);
+
+    for (uint8_t i = 0; i < screen->num_lines; ++i) {
+        const ui_line_t *l = &screen->lines[i];
+        ssd1306_line(ssd, l->x0, l->y0, l->x1, l->y1, true);
+    }
+
+    for (uint8_t i = 0; i < screen->num_labels; ++i) {
+        const ui_label_t *l = &screen->labels[i];
+        uint8_t x = l->x;
+        for (const char *c = l->text; *c; ++c, x += UI_CHAR_WIDTH)
+            ssd1306_draw_char(ssd, *c, x, l->y);
+    }
+
+    if (screen->chart && screen->chart->count)
+        ui_sparkline_draw(ui, screen->chart);
+
+    // Campos começam em branco: o primeiro ui_set_field desenha o texto inteiro
+    for (uint8_t i = 0; i < screen->num_fields && i < UI_MAX_FIELDS; ++i) {
+        memset(ui->text[i], ' ', screen->fields[i].width);
+        ui->text[i][screen->fields[i].width] = '\0';
+    }
+}
+
+void ui_set_field(ui_t *ui, uint8_t id, const char *text) {
+    const ui_screen_t *screen = ui->screen;
+    if (!screen)
+        return;
+
+    for (uint8_t i = 0; i < screen->num_fields && i < UI_MAX_FIELDS; ++i) {
+        const ui_field_t *f = &screen->fields[i];
+        if (f->id != id)
+            continue;
+
+        char *atual = ui->text[i];
+        bool fim = false;
+        for (uint8_t k = 0; k < f->width && k < UI_FIELD_MAX; ++k) {
+            if (!fim && !text[k])
+                fim = true;
+            char c = fim ? ' ' : text[k];
+            if (c != atual[k]) {
+                atual[k] = c;
+                ssd1306_draw_char(ui->ssd, c, f->x + k * UI_CHAR_WIDTH, f->y);
+                ui->chars_drawn++;
+            }
+        }
+        return;
+    }
+}
+
+void ui_sparkline_push(ui_t *ui, ui_sparkline_t *chart, float value) {
+    uint8_t width = ui_sparkline_width(chart);
+
+    chart->values[chart->head] = value;
+    chart->head = (chart->head + 1) % width;
+    if (chart->count < width)
+        chart->count++;
+
+    bool nova_escala = ui_sparkline_rescale(chart);
+    if (!ui->screen || ui->screen->chart != chart)
+        return;
+
+    if (nova_escala) {
+        ui_sparkline_draw(ui, chart);
+        return;
+    }
+
+    // Desloca o gráfico uma coluna e desenha apenas a amostra nova
+    ssd1306_scroll_left(ui->ssd, chart->x0, chart->x1, chart->y0, chart->y1);
+    ssd1306_vline(ui->ssd, chart->x1, chart->y0, chart->y1, false);
+    ui_sparkline_column(ui, chart, chart->x1, chart->count - 1);
+
+    // Com o gráfico cheio, a primeira coluna ligava-se a uma amostra que saiu do histórico
+    if (chart->count == width && width == chart->x1 - chart->x0 + 1) {
+        ssd1306_vline(ui->ssd, chart->x0, chart->y0, chart->y1, false);
+        ui_sparkline_column(ui, chart, chart->x0, 0);
+    }
+}
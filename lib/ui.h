@@ -0,0 +1,87 @@
+#ifndef UI_H
+#define UI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+
+#define UI_MAX_FIELDS 8     // Campos por tela
+#define UI_FIELD_MAX 16     // Caracteres por campo (a tela tem 16 colunas de 8 pixels)
+#define UI_CHAR_WIDTH 8
+#define UI_SPARK_MAX 120    // Amostras guardadas por gráfico (uma por coluna)
+
+// Texto fixo da tela
+typedef struct {
+    uint8_t x, y;
+    const char *text;
+} ui_label_t;
+
+// Linha fixa da tela
+typedef struct {
+    uint8_t x0, y0, x1, y1;
+} ui_line_t;
+
+// Campo de valor: identificador escolhido pela aplicação e largura máxima em caracteres
+typedef struct {
+    uint8_t id;
+    uint8_t x, y;
+    uint8_t width;
+} ui_field_t;
+
+/**
+ * Gráfico de linha das amostras recentes, com a mais nova na coluna x1. A cada amostra a área é
+ * deslocada uma coluna para a esquerda e só a nova coluna é desenhada. A escala acompanha o mínimo
+ * e o máximo das amostras, arredondados para múltiplos de step; o gráfico inteiro só é redesenhado
+ * quando essa escala muda. O histórico é mantido mesmo com o gráfico fora da tela.
+ */
+typedef struct {
+    uint8_t x0, x1, y0, y1;        // Área do gráfico, inclusiva
+    float step;                    // Resolução da escala automática
+    float values[UI_SPARK_MAX];
+    uint8_t count, head;           // Amostras guardadas; posição da próxima
+    float lo, hi;                  // Escala atual
+} ui_sparkline_t;
+
+#define UI_SPARKLINE(x0, x1, y0, y1, step) { (x0), (x1), (y0), (y1), (step), {0}, 0, 0, 0.0f, 0.0f }
+
+/**
+ * Layout estático de uma tela. A moldura, as linhas e os rótulos são desenhados apenas
+ * quando a tela é exibida; depois disso só os campos mudam.
+ */
+typedef struct {
+    bool border;               // Retângulo em volta da tela
+    const ui_line_t *lines;
+    uint8_t num_lines;
+    const ui_label_t *labels;
+    uint8_t num_labels;
+    const ui_field_t *fields;
+    uint8_t num_fields;
+    ui_sparkline_t *chart;     // Gráfico da tela, ou NULL
+} ui_screen_t;
+
+typedef struct {
+    ssd1306_t *ssd;
+    const ui_screen_t *screen;                    // Tela exibida
+    char text[UI_MAX_FIELDS][UI_FIELD_MAX + 1];   // Texto desenhado em cada campo da tela
+    uint16_t chars_drawn;                         // Caracteres redesenhados desde a última consulta
+} ui_t;
+
+void ui_init(ui_t *ui, ssd1306_t *ssd);
+
+// Exibe a tela. Se ela já está exibida, não faz nada
+void ui_show(ui_t *ui, const ui_screen_t *screen);
+
+// Força o redesenho completo da tela atual na próxima chamada de ui_show
+void ui_invalidate(ui_t *ui);
+
+/**
+ * Atualiza o campo com o identificador id na tela atual. Apenas os caracteres diferentes do
+ * texto já desenhado são redesenhados; o texto é completado com espaços até a largura do campo.
+ * Campos que não existem na tela atual são ignorados.
+ */
+void ui_set_field(ui_t *ui, uint8_t id, const char *text);
+
+// Acrescenta uma amostra ao gráfico; se ele está na tela atual, desenha a nova coluna
+void ui_sparkline_push(ui_t *ui, ui_sparkline_t *chart, float value);
+
+#endif // UI_H
@@ -1,3 +1,5 @@
+#include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,29 +7,32 @@
 #include "pico/cyw43_arch.h"
 #include "lwip/tcp.h"
 
+#include "config.h"
+#include "history.h"
+#include "http_parser.h"
+#include "metrics.h"
+#include "prof.h"
+#include "memstats.h"
+#include "rules.h"
+#include "seqlatch.h"
 #include "webserver.h"
+#include "websocket.h"
 
-#define MAX_BUFFER_SIZE 20
+#define MAX_BUFFER_SIZE WEBSERVER_MAX_SAMPLES
 
+// Converte o valor de uma macro em string literal, para embutir constantes no JavaScript
+#define STR_(x) #x
+#define STR(x) STR_(x)
 
-extern volatile float hum_max_user;
-extern volatile float hum_min_user;
-extern volatile float temp_max_user;
-extern volatile float temp_min_user;
-extern volatile float press_max_user;
-extern volatile float press_min_user;
 
-extern volatile float temperature;
-extern volatile float pressure;
-extern volatile float humidity;
-extern float temp_buffer[MAX_BUFFER_SIZE];
-extern float hum_buffer[MAX_BUFFER_SIZE];
-extern float press_buffer[MAX_BUFFER_SIZE];
-extern int buffer_index;
+extern config_store_t config;
+extern rules_t regras;
 
-
-#define WIFI_SSID "wifi"
-#define WIFI_PASS "senha"
+// Histórico de amostras: o laço principal grava em amostras_escrita e publica o conjunto inteiro;
+// os handlers, no contexto do lwIP, leem uma cópia consistente sem bloquear
+static webserver_samples_t amostras_escrita;
+static webserver_samples_t amostras_copias[2];
+static seqlatch_t amostras = SEQLATCH_INIT(&amostras_copias[0], &amostras_copias[1], sizeof(webserver_samples_t));
 
 const char HTML_PART1[] =
 "<!DOCTYPE html><html lang=\"pt-BR\"><head><meta charset=\"UTF-8\">"
@@ -49,7 +54,7 @@ const char HTML_PART2[] =
 "<div class='input-group'>"
 "<input type='number' id='temp_min' placeholder='Mínimo °C'>"
 "<input type='number' id='temp_max' placeholder='Máximo °C'>"
-"<button onclick='atualizarLimite(\"temp\")'>Atualizar Limites</button>"
+"<button onclick='salvarLimites()'>Atualizar Limites</button>"
 "</div></div>";
 
 
@@ -60,7 +65,7 @@ const char HTML_PART3[] =
 "<div class='input-group'>"
 "<input type='number' id='hum_min' placeholder='Mínimo %'>"
 "<input type='number' id='hum_max' placeholder='Máximo %'>"
-"<button onclick='atualizarLimite(\"hum\")'>Atualizar Limites</button>"
+"<button onclick='salvarLimites()'>Atualizar Limites</button>"
 "</div></div>";
 
 
@@ -69,9 +74,16 @@ const char HTML_PART4[] =
 "<h2>Pressão (kPa)</h2>"
 "<canvas id=\"pressChart\"></canvas>"
 "<div class='input-group'>"
-"<input type='number' id='press_min' placeholder='Mínimo Pa'>"
-"<input type='number' id='press_max' placeholder='Máximo Pa'>"
-"<button onclick='atualizarLimite(\"press\")'>Atualizar Limites</button>"
+"<input type='number' id='press_min' placeholder='Mínimo kPa'>"
+"<input type='number' id='press_max' placeholder='Máximo kPa'>"
+"<button onclick='salvarLimites()'>Atualizar Limites</button>"
+"</div></div>"
+"<div class=\"section\">"
+"<h2>Regras de alarme</h2>"
+"<ul id='regras'></ul>"
+"<div class='input-group'>"
+"<input type='text' id='regra' placeholder='ex.: temp > 30 for 60' style='width:70%'>"
+"<button onclick='adicionarRegra()'>Adicionar</button>"
 "</div></div>";
 
 
@@ -102,195 +114,1242 @@ const char HTML_PART5[] =
 ;
 
 const char HTML_PART6[] =
+"let ultimoSeq = 0;"
+"const MAX_AMOSTRAS = " STR(MAX_BUFFER_SIZE) ";"
+"function anexar(chart, rotulos, valores) {"
+"  chart.data.labels.push(...rotulos);"
+"  chart.data.datasets[0].data.push(...valores);"
+"  const excesso = chart.data.labels.length - MAX_AMOSTRAS;"
+"  if (excesso > 0) {"
+"    chart.data.labels.splice(0, excesso);"
+"    chart.data.datasets[0].data.splice(0, excesso);"
+"  }"
+"  chart.update();"
+"}"
 "function atualizarGraficos() {"
-"fetch('/estado')"
+"fetch('/estado?since=' + ultimoSeq)"
 ".then(res => res.json())"
 ".then(data => {"
-"  const labels = Array.from({length: data.temperaturas.length}, (_, i) => i + 1);"
-"  tempChart.data.labels = labels;"
-"  humChart.data.labels = labels;"
-"  pressChart.data.labels = labels;"
-"  tempChart.data.datasets[0].data = data.temperaturas;"
-"  humChart.data.datasets[0].data = data.umidades;"
-"  pressChart.data.datasets[0].data = data.pressoes;"
-"  tempChart.update();"
-"  humChart.update();"
-"  pressChart.update();"
+"  if (data.seq < ultimoSeq) {"
+"    [tempChart, humChart, pressChart].forEach(c => { c.data.labels = []; c.data.datasets[0].data = []; });"
+"  }"
+"  const n = data.temperaturas.length;"
+"  const rotulos = Array.from({length: n}, (_, i) => data.seq - n + i + 1);"
+"  anexar(tempChart, rotulos, data.temperaturas);"
+"  anexar(humChart, rotulos, data.umidades);"
+"  anexar(pressChart, rotulos, data.pressoes);"
+"  ultimoSeq = data.seq;"
 "});"
 "}"
-"setInterval(atualizarGraficos, 5000);"
-"window.onload = atualizarGraficos;";
+"function novaAmostra(seq, t, h, p) {"
+"  if (seq < ultimoSeq) {"
+"    [tempChart, humChart, pressChart].forEach(c => { c.data.labels = []; c.data.datasets[0].data = []; });"
+"  } else if (seq == ultimoSeq) return;"
+"  anexar(tempChart, [seq], [t]);"
+"  anexar(humChart, [seq], [h]);"
+"  anexar(pressChart, [seq], [p]);"
+"  ultimoSeq = seq;"
+"}"
+"function iniciarEventos() {"
+"  if (!window.EventSource) { setInterval(atualizarGraficos, 5000); return; }"
+"  const fonte = new EventSource('/eventos');"
+"  fonte.onmessage = e => { const a = JSON.parse(e.data); novaAmostra(a.seq, a.t, a.h, a.p); };"
+"  fonte.onerror = () => {"
+"    if (fonte.readyState === EventSource.CLOSED) setInterval(atualizarGraficos, 5000);"
+"  };"
+"}"
+"function iniciarWebSocket() {"
+"  if (!window.WebSocket) { iniciarEventos(); return; }"
+"  const ws = new WebSocket('ws://' + location.host + '/ws');"
+"  ws.binaryType = 'arraybuffer';"
+"  let aberto = false;"
+"  ws.onopen = () => { aberto = true; };"
+"  ws.onmessage = e => {"
+"    const v = new DataView(e.data);"
+"    novaAmostra(v.getUint32(0, true), v.getInt16(8, true) / 100, v.getInt16(10, true) / 100, v.getInt32(12, true) / 1000);"
+"  };"
+"  ws.onclose = () => { if (aberto) setTimeout(iniciarWebSocket, 3000); else iniciarEventos(); };"
+"}"
+"window.onload = () => {"
+"  atualizarGraficos(); iniciarWebSocket(); regras('');"
+"  fetch('/config').then(res => res.json()).then(mostrarLimites);"
+"};";
 
 const char HTML_PART7[] =
-"function atualizarLimite(tipo) {"
-"  const min = document.getElementById(tipo + '_min').value;"
-"  const max = document.getElementById(tipo + '_max').value;"
-"  const params = new URLSearchParams({ tipo, min, max }).toString();"
-"  fetch('/limites?' + params)"
-"    .then(res => res.text())"
-"    .then(msg => console.log('Resposta:', msg))"
+"const canais = ['temp', 'hum', 'press'];"
+"function mostrarLimites(d) {"
+"  if (d.erro) { alert(d.erro); return; }"
+"  canais.forEach(c => {"
+"    document.getElementById(c + '_min').value = d[c].min;"
+"    document.getElementById(c + '_max').value = d[c].max;"
+"  });"
+"}"
+"function salvarLimites() {"
+"  const params = new URLSearchParams();"
+"  canais.forEach(c => ['min', 'max'].forEach(k => {"
+"    const v = document.getElementById(c + '_' + k).value;"
+"    if (v !== '') params.set(c + '_' + k, v);"
+"  }));"
+"  fetch('/limites?' + params).then(res => res.json()).then(mostrarLimites)"
 "    .catch(err => console.error('Erro:', err));"
 "}"
+"function regras(query) {"
+"  fetch('/regras' + query).then(res => res.json()).then(d => {"
+"    if (d.erro) { alert(d.erro); return; }"
+"    const lista = document.getElementById('regras');"
+"    lista.innerHTML = '';"
+"    d.regras.forEach(r => {"
+"      const item = document.createElement('li');"
+"      item.textContent = r.regra + (r.ativa ? ' (ativa) ' : ' ');"
+"      const remover = document.createElement('button');"
+"      remover.textContent = 'Remover';"
+"      remover.onclick = () => regras('?del=' + r.id);"
+"      item.appendChild(remover);"
+"      lista.appendChild(item);"
+"    });"
+"  });"
+"}"
+"function adicionarRegra() {"
+"  regras('?add=' + encodeURIComponent(document.getElementById('regra').value));"
+"}"
 "</script></body></html>";
 
 
 
-struct http_state {
-    char response[4096]; // Aumentado para suportar HTML completo
-    size_t len;
-    size_t sent;
+// Página principal enviada direto da flash, sem cópia
+static const char *const HTML_PARTS[] = {
+    HTML_PART1, HTML_PART2, HTML_PART3, HTML_PART4, HTML_PART5, HTML_PART6, HTML_PART7
 };
+static const uint16_t HTML_PART_LENS[] = {
+    sizeof(HTML_PART1) - 1, sizeof(HTML_PART2) - 1, sizeof(HTML_PART3) - 1, sizeof(HTML_PART4) - 1,
+    sizeof(HTML_PART5) - 1, sizeof(HTML_PART6) - 1, sizeof(HTML_PART7) - 1
+};
+#define HTML_NUM_PARTS (sizeof(HTML_PARTS) / sizeof(HTML_PARTS[0]))
 
-static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len) {
-    struct http_state *hs = (struct http_state *)arg;
-    hs->sent += len;
 
-    if (hs->sent >= hs->len) {
-        tcp_close(tpcb);
-        free(hs);
-    } else {
-        tcp_write(tpcb, hs->response + hs->sent, hs->len - hs->sent, TCP_WRITE_FLAG_COPY);
+
+// ======== CONEXÕES ===========
+
+#define HTTP_MAX_CONNS 8          // Estados de conexão alocados estaticamente, incluindo /eventos e /ws
+#define STREAM_MAX_CLIENTS 4      // Quantos deles podem ser de transmissão contínua
+
+#if MEMP_NUM_TCP_PCB <= HTTP_MAX_CONNS
+#error "MEMP_NUM_TCP_PCB (lwipopts.h) deve ser maior que HTTP_MAX_CONNS, para o pool do servidor valer"
+#endif
+#define HTTP_IDLE_TIMEOUT_S 10    // Conexão keep-alive sem atividade é fechada após esse tempo
+#define HTTP_POLL_INTERVAL 2      // Intervalo do tcp_poll, em unidades de 500 ms
+#define STREAM_BACKLOG_MAX 1024   // Bytes enviados e ainda não confirmados por cliente. Acima disso, o cliente é descartado
+#define SSE_EVENT_SIZE 128
+#define WS_RX_BUFFER_SIZE 132     // Maior quadro de controle do cliente: 125 bytes de dados + 6 de cabeçalho
+
+// Formato de /export. EXPORT_CSV_HEADER é o CSV antes da linha de cabeçalho ser enviada
+enum export_format {
+    EXPORT_NONE,
+    EXPORT_CSV_HEADER,
+    EXPORT_CSV,
+    EXPORT_NDJSON
+};
+
+enum conn_kind {
+    CONN_FREE,
+    CONN_HTTP,  // Requisição/resposta, com keep-alive
+    CONN_SSE,   // /eventos
+    CONN_WS     // /ws
+};
+
+struct http_conn {
+    struct tcp_pcb *pcb;
+    uint8_t kind;
+    uint8_t idle;         // Segundos sem atividade
+    bool keep_alive;      // Mantém a conexão aberta ao fim da resposta
+    uint8_t tx_part;      // Próxima parte da página a enviar; HTML_NUM_PARTS quando não há envio pendente
+    uint16_t tx_offset;   // Posição dentro dessa parte
+    int8_t tx_metrics;    // Próxima parte de /metrics a enviar; -1 quando não há envio pendente
+    bool tx_chunked;      // /metrics e /export com Transfer-Encoding: chunked (HTTP/1.1)
+    uint8_t tx_export;    // Formato de /export em envio; EXPORT_NONE quando não há envio pendente
+    uint16_t export_step; // Períodos do histórico por linha
+    uint32_t export_next; // Próximo período a exportar
+    uint32_t export_end;  // Fim do intervalo pedido (exclusivo)
+    uint32_t tx_us;       // Tempo gasto gerando /metrics até agora
+    uint16_t backlog;     // Bytes na fila de envio aguardando ACK
+    uint8_t rx_len;       // WebSocket: bytes de um quadro do cliente ainda incompleto
+    union {
+        http_parser_t parser;          // CONN_HTTP: requisição em andamento
+        uint8_t rx[WS_RX_BUFFER_SIZE]; // CONN_WS: quadro recebido do cliente
+    };
+};
+
+static struct http_conn conns[HTTP_MAX_CONNS];
+static uint32_t conns_rejected = 0;  // Conexões recusadas com o pool cheio
+static uint32_t stream_dropped = 0;  // Clientes de /eventos e /ws descartados por estarem lentos demais
+static uint32_t ws_frames_sent = 0;  // Quadros de amostra enviados via WebSocket
+static uint32_t ws_bytes_sent = 0;   // Bytes desses quadros, incluindo cabeçalho
+static uint32_t http_not_found = 0;  // Requisições para rotas inexistentes
+static uint32_t http_refused = 0;    // Requisições inválidas ou com método não aceito
+static uint32_t metrics_scrapes = 0;
+static uint32_t metrics_truncated = 0; // Partes cujo texto não coube em METRICS_CHUNK_MAX
+static metrics_histogram_t metrics_scrape_us = METRICS_HISTOGRAM(6); // Tempo de CPU por leitura de /metrics
+
+// Há uma resposta em andamento, enviada conforme a fila de envio esvazia
+static bool http_sending(const struct http_conn *c) {
+    return c->tx_part < HTML_NUM_PARTS || c->tx_metrics >= 0 || c->tx_export != EXPORT_NONE;
+}
+
+static void conn_release(struct http_conn *c) {
+    if (c->pcb) {
+        tcp_arg(c->pcb, NULL);
+        tcp_sent(c->pcb, NULL);
+        tcp_recv(c->pcb, NULL);
+        tcp_err(c->pcb, NULL);
+        tcp_poll(c->pcb, NULL, 0);
     }
+    c->pcb = NULL;
+    c->kind = CONN_FREE;
+}
 
+// Fecha a conexão e libera o estado. Retorna ERR_ABRT se foi preciso abortar (o callback deve repassar esse valor)
+static err_t conn_close(struct http_conn *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    conn_release(c);
+    if (tcp_close(pcb) != ERR_OK) {
+        tcp_abort(pcb);
+        return ERR_ABRT;
+    }
     return ERR_OK;
 }
 
-static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
-    if (!p) {
-        tcp_close(tpcb);
-        return ERR_OK;
+// Descarta um cliente que não acompanha o ritmo das amostras
+static void conn_drop(struct http_conn *c) {
+    struct tcp_pcb *pcb = c->pcb;
+    conn_release(c);
+    tcp_abort(pcb);
+    stream_dropped++;
+}
+
+/**
+ * Obtém um estado livre do pool. Com o pool cheio, fecha a conexão keep-alive ociosa há mais tempo.
+ * Retorna NULL se todas as conexões estão ocupadas.
+ */
+static struct http_conn *conn_alloc(void) {
+    struct http_conn *ociosa = NULL;
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+        struct http_conn *c = &conns[i];
+        if (c->kind == CONN_FREE) return c;
+        if (c->kind == CONN_HTTP && !http_sending(c) && (!ociosa || c->idle > ociosa->idle)) {
+            ociosa = c;
+        }
+    }
+
+    if (ociosa) {
+        conn_close(ociosa);
+    }
+    return ociosa;
+}
+
+static int stream_count(void) {
+    int n = 0;
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+        if (conns[i].kind == CONN_SSE || conns[i].kind == CONN_WS) n++;
+    }
+    return n;
+}
+
+// Continua o envio da página principal conforme há espaço na fila de envio
+static void http_send_page(struct http_conn *c) {
+    while (c->tx_part < HTML_NUM_PARTS) {
+        uint16_t restante = HTML_PART_LENS[c->tx_part] - c->tx_offset;
+        uint16_t n = tcp_sndbuf(c->pcb);
+        if (n == 0) break;
+        if (n > restante) n = restante;
+
+        bool ultima = (c->tx_part == HTML_NUM_PARTS - 1) && (n == restante);
+        if (tcp_write(c->pcb, HTML_PARTS[c->tx_part] + c->tx_offset, n, ultima ? 0 : TCP_WRITE_FLAG_MORE) != ERR_OK) {
+            break;
+        }
+
+        c->tx_offset += n;
+        if (c->tx_offset == HTML_PART_LENS[c->tx_part]) {
+            c->tx_part++;
+            c->tx_offset = 0;
+        }
+    }
+    tcp_output(c->pcb);
+}
+
+#define HTTP_CHUNK_HEADER 6  // Tamanho do pedaço em hexadecimal e "\r\n", reservados antes do texto
+#define HTTP_CHUNK_TRAILER 7 // "\r\n" depois do texto e o pedaço final "0\r\n\r\n"
+
+/**
+ * Envolve o texto em *dados (len bytes, com HTTP_CHUNK_HEADER livres antes e HTTP_CHUNK_TRAILER depois)
+ * num pedaço de Transfer-Encoding: chunked e, com fim, acrescenta o pedaço final. *dados passa a
+ * apontar para o início do pedaço; retorna o novo tamanho.
+ */
+static size_t http_chunk_wrap(char **dados, size_t len, bool fim) {
+    if (len) {
+        char tamanho[HTTP_CHUNK_HEADER + 1];
+        int n = snprintf(tamanho, sizeof(tamanho), "%x\r\n", (unsigned)len);
+        *dados -= n;
+        memcpy(*dados, tamanho, n);
+        len += n;
+        memcpy(*dados + len, "\r\n", 2);
+        len += 2;
+    }
+    if (fim) {
+        memcpy(*dados + len, "0\r\n\r\n", 5);
+        len += 5;
+    }
+    return len;
+}
+
+/**
+ * Continua o envio de /metrics: gera o texto de uma parte por vez, apenas quando ela cabe inteira na
+ * fila de envio. O buffer é um só para todas as conexões, já que cada passo é enviado (copiado) na hora.
+ */
+static void http_send_metrics(struct http_conn *c) {
+    static char buf[HTTP_CHUNK_HEADER + METRICS_CHUNK_MAX + HTTP_CHUNK_TRAILER];
+
+    while (c->tx_metrics >= 0 && tcp_sndbuf(c->pcb) >= sizeof(buf)) {
+        uint32_t inicio = time_us_32();
+
+        metrics_writer_t w;
+        metrics_writer_init(&w, buf + HTTP_CHUNK_HEADER, METRICS_CHUNK_MAX);
+        bool fim = !metrics_collect(c->tx_metrics, &w);
+
+        char *dados = w.buf;
+        size_t len = w.len;
+        if (c->tx_chunked) {
+            len = http_chunk_wrap(&dados, len, fim);
+        }
+
+        // Sem memória para o segmento: a mesma parte é gerada de novo no próximo tcp_sent
+        if (len && tcp_write(c->pcb, dados, len, fim ? TCP_WRITE_FLAG_COPY : TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK) {
+            break;
+        }
+
+        if (w.overflow) metrics_truncated++;
+        c->tx_us += time_us_32() - inicio;
+        if (fim) {
+            c->tx_metrics = -1;
+            metrics_scrapes++;
+            metrics_histogram_observe(&metrics_scrape_us, c->tx_us);
+        } else {
+            c->tx_metrics++;
+        }
+    }
+    tcp_output(c->pcb);
+}
+
+#define EXPORT_CHUNK_MAX 512 // Texto de /export gerado por passo: ~12 linhas
+
+// Uma linha de /export. Retorna o tamanho, como snprintf
+static int export_format_line(char *buf, size_t size, uint8_t formato, const history_point_t *pt) {
+    if (formato == EXPORT_NDJSON) {
+        return snprintf(buf, size, "{\"t\":%lu,\"temperatura\":%.2f,\"umidade\":%.2f,\"pressao\":%.2f}\n",
+                        (unsigned long)pt->t_s, pt->temperature, pt->humidity, pt->pressure);
+    }
+    return snprintf(buf, size, "%lu,%.2f,%.2f,%.2f\n",
+                    (unsigned long)pt->t_s, pt->temperature, pt->humidity, pt->pressure);
+}
+
+/**
+ * Continua o envio de /export: as linhas são geradas do histórico a cada passo, só quando o pedaço
+ * cabe inteiro na fila de envio, com o mesmo buffer compartilhado de /metrics. O cursor só avança
+ * depois que tcp_write aceita os dados, então uma falha refaz o mesmo trecho no próximo tcp_sent.
+ */
+static void http_send_export(struct http_conn *c) {
+    static char buf[HTTP_CHUNK_HEADER + EXPORT_CHUNK_MAX + HTTP_CHUNK_TRAILER];
+
+    while (c->tx_export != EXPORT_NONE && tcp_sndbuf(c->pcb) >= sizeof(buf)) {
+        char *dados = buf + HTTP_CHUNK_HEADER;
+        size_t len = 0;
+
+        uint8_t formato = c->tx_export;
+        if (formato == EXPORT_CSV_HEADER) {
+            len = snprintf(dados, EXPORT_CHUNK_MAX, "t,temperatura,umidade,pressao\n");
+            formato = EXPORT_CSV;
+        }
+
+        // Linhas até encher o pedaço; a que não cabe fica para o próximo
+        uint32_t p = c->export_next;
+        while (p < c->export_end) {
+            history_point_t pt;
+            if (history_get(p, c->export_step, &pt)) {
+                int n = export_format_line(dados + len, EXPORT_CHUNK_MAX - len, formato, &pt);
+                if (n >= (int)(EXPORT_CHUNK_MAX - len)) break;
+                len += n;
+            }
+            p += c->export_step;
+        }
+        bool fim = p >= c->export_end;
+
+        if (c->tx_chunked) {
+            len = http_chunk_wrap(&dados, len, fim);
+        }
+        if (len && tcp_write(c->pcb, dados, len, fim ? TCP_WRITE_FLAG_COPY : TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK) {
+            break;
+        }
+
+        c->export_next = p;
+        c->tx_export = fim ? EXPORT_NONE : formato;
+    }
+    tcp_output(c->pcb);
+}
+
+// Continua a resposta em andamento, se houver
+static void http_send_pending(struct http_conn *c) {
+    if (c->tx_part < HTML_NUM_PARTS) {
+        http_send_page(c);
+    } else if (c->tx_metrics >= 0) {
+        http_send_metrics(c);
+    } else if (c->tx_export != EXPORT_NONE) {
+        http_send_export(c);
+    }
+}
+
+// Cabeçalho "Connection" conforme a conexão será mantida ou não
+static const char *http_connection_header(const struct http_conn *c) {
+    return c->keep_alive
+        ? "Connection: keep-alive\r\nKeep-Alive: timeout=" STR(HTTP_IDLE_TIMEOUT_S) "\r\n"
+        : "Connection: close\r\n";
+}
+
+// Envia uma resposta completa (cabeçalho e corpo) copiando-a para a fila de envio do lwIP
+static void http_respond(struct http_conn *c, const char *status, const char *content_type,
+                         const char *body, size_t body_len) {
+    char header[192];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: %s\r\n"
+                       "Content-Length: %d\r\n"
+                       "%s\r\n",
+                       status, content_type, (int)body_len, http_connection_header(c));
+
+    if (tcp_sndbuf(c->pcb) < len + body_len) {
+        // Sem espaço para a resposta: encerra a conexão para o cliente tentar de novo
+        c->keep_alive = false;
+        return;
+    }
+    tcp_write(c->pcb, header, len, body_len ? TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE : TCP_WRITE_FLAG_COPY);
+    if (body_len) {
+        tcp_write(c->pcb, body, body_len, TCP_WRITE_FLAG_COPY);
+    }
+    tcp_output(c->pcb);
+}
+
+static void http_respond_status(struct http_conn *c, const char *status) {
+    c->keep_alive = false;
+    http_respond(c, status, "text/plain", "", 0);
+}
+
+
+
+// ======== TRANSMISSÃO CONTÍNUA: SERVER-SENT EVENTS (/eventos) E WEBSOCKET (/ws) ===========
+
+// Formata uma amostra como evento SSE. O "id" permite ao navegador retomar a partir da última amostra recebida
+static int sse_format_event(char *buf, size_t size, uint32_t seq, float t, float h, float p) {
+    return snprintf(buf, size,
+                    "id: %lu\ndata: {\"seq\":%lu,\"t\":%.2f,\"h\":%.2f,\"p\":%.2f}\n\n",
+                    (unsigned long)seq, (unsigned long)seq, t, h, p);
+}
+
+// Envia dados a um cliente, respeitando o limite de backlog
+static bool stream_send(struct http_conn *c, const void *data, u16_t len) {
+    if (c->backlog + len > STREAM_BACKLOG_MAX || tcp_sndbuf(c->pcb) < len) {
+        return false;
+    }
+    if (tcp_write(c->pcb, data, len, TCP_WRITE_FLAG_COPY) != ERR_OK) {
+        return false;
+    }
+    c->backlog += len;
+    return true;
+}
+
+// Encerra o WebSocket por erro do cliente: envia o close com o código e fecha a conexão
+static bool ws_fail(struct http_conn *c, uint16_t code, err_t *err) {
+    uint8_t frame[WS_CLOSE_FRAME_SIZE];
+    ws_close_frame(frame, code);
+    stream_send(c, frame, sizeof(frame));
+    tcp_output(c->pcb);
+    *err = conn_close(c);
+    return false;
+}
+
+// Responde aos quadros de controle do cliente (ping e close). Retorna false se a conexão foi fechada
+static bool ws_process_rx(struct http_conn *c, err_t *err) {
+    size_t pos = 0;
+    while (pos < c->rx_len) {
+        // O RFC 6455 exige máscara nos quadros do cliente. Dados acima de 125 bytes (tamanho
+        // estendido de 16 ou 64 bits) não cabem no buffer, dimensionado para quadros de controle
+        if (c->rx_len - pos >= 2) {
+            if (!(c->rx[pos + 1] & 0x80)) return ws_fail(c, WS_CLOSE_PROTOCOL_ERROR, err);
+            if ((c->rx[pos + 1] & 0x7F) > 125) return ws_fail(c, WS_CLOSE_TOO_BIG, err);
+        }
+
+        uint8_t opcode;
+        uint8_t *payload;
+        size_t payload_len;
+        size_t used = ws_decode_frame(c->rx + pos, c->rx_len - pos, &opcode, &payload, &payload_len);
+        if (!used) break;
+        pos += used;
+
+        if (opcode == WS_OPCODE_PING || opcode == WS_OPCODE_CLOSE) {
+            uint8_t header[4];
+            size_t hlen = ws_frame_header(header, opcode == WS_OPCODE_PING ? WS_OPCODE_PONG : WS_OPCODE_CLOSE, payload_len);
+            stream_send(c, header, hlen);
+            if (payload_len) stream_send(c, payload, payload_len);
+            tcp_output(c->pcb);
+        }
+
+        if (opcode == WS_OPCODE_CLOSE) {
+            *err = conn_close(c);
+            return false;
+        }
+    }
+
+    // Mantém no início do buffer o quadro ainda incompleto, que sempre cabe nele (no máximo 131 bytes)
+    if (pos < c->rx_len) {
+        memmove(c->rx, c->rx + pos, c->rx_len - pos);
+        c->rx_len -= pos;
+    } else {
+        c->rx_len = 0;
+    }
+    return true;
+}
+
+static err_t ws_recv(struct http_conn *c, struct pbuf *p) {
+    err_t err = ERR_OK;
+    u16_t offset = 0;
+    while (offset < p->tot_len) {
+        u16_t n = pbuf_copy_partial(p, c->rx + c->rx_len, sizeof(c->rx) - c->rx_len, offset);
+        c->rx_len += n;
+        offset += n;
+        if (!ws_process_rx(c, &err)) break;
+    }
+    return err;
+}
+
+// Converte a conexão em cliente de transmissão contínua. Acima do limite, responde 503
+static bool stream_accept(struct http_conn *c, uint8_t kind) {
+    if (stream_count() >= STREAM_MAX_CLIENTS) {
+        http_respond_status(c, "503 Service Unavailable");
+        return false;
+    }
+    c->kind = kind;
+    c->keep_alive = true;
+    c->backlog = 0;
+    c->rx_len = 0;
+    return true;
+}
+
+// Registra a conexão como cliente SSE e reenvia as amostras perdidas desde Last-Event-ID
+static void sse_accept(struct http_conn *c, const http_parser_t *req) {
+    bool retomar = req->flags & HTTP_FLAG_LAST_EVENT_ID;
+    uint32_t since = req->last_event_id;
+    if (!stream_accept(c, CONN_SSE)) return;
+
+    const char *header =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "retry: 3000\n\n";
+    tcp_write(c->pcb, header, strlen(header), TCP_WRITE_FLAG_COPY);
+
+    // Reconexão do EventSource: envia o que ainda está no buffer depois do último id recebido
+    if (retomar) {
+        webserver_samples_t a;
+        seqlatch_read(&amostras, &a);
+        uint32_t seq = a.seq;
+        uint32_t inicio = seq > MAX_BUFFER_SIZE ? seq - MAX_BUFFER_SIZE : 0;
+        if (since < seq && since > inicio) inicio = since;
+
+        char ev[SSE_EVENT_SIZE];
+        for (uint32_t s = inicio; s != seq; s++) {
+            uint32_t idx = s % MAX_BUFFER_SIZE;
+            int len = sse_format_event(ev, sizeof(ev), s + 1, a.temperature[idx], a.humidity[idx], a.pressure[idx]);
+            if (!stream_send(c, ev, len)) break;
+        }
+    }
+    tcp_output(c->pcb);
+}
+
+// Handshake do RFC 6455: responde 101 com o Sec-WebSocket-Accept calculado a partir da chave do cliente
+static void ws_accept(struct http_conn *c, const http_parser_t *req) {
+    if (!(req->flags & HTTP_FLAG_UPGRADE_WS) || req->ws_key[0] == '\0') {
+        http_respond_status(c, "400 Bad Request");
+        return;
+    }
+
+    // Calcula antes de trocar o tipo da conexão: a chave está no parser, que divide memória com o buffer do WebSocket
+    char accept[WS_ACCEPT_SIZE];
+    ws_accept_key(req->ws_key, strlen(req->ws_key), accept);
+
+    if (!stream_accept(c, CONN_WS)) return;
+
+    char header[160];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 101 Switching Protocols\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Accept: %s\r\n\r\n",
+                       accept);
+    tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY);
+    tcp_nagle_disable(c->pcb); // Quadros pequenos devem sair assim que produzidos
+    tcp_output(c->pcb);
+}
+
+void webserver_publish_sample(uint32_t seq, float temperature, float humidity, float pressure) {
+    uint32_t idx = (seq - 1) % MAX_BUFFER_SIZE;
+    amostras_escrita.temperature[idx] = temperature;
+    amostras_escrita.humidity[idx] = humidity;
+    amostras_escrita.pressure[idx] = pressure;
+    amostras_escrita.seq = seq;
+    seqlatch_publish(&amostras, &amostras_escrita);
+
+    char ev[SSE_EVENT_SIZE];
+    int ev_len = sse_format_event(ev, sizeof(ev), seq, temperature, humidity, pressure);
+
+    uint8_t frame[WS_SAMPLE_FRAME_SIZE];
+    ws_encode_sample(frame, seq, to_ms_since_boot(get_absolute_time()), temperature, humidity, pressure);
+
+    cyw43_arch_lwip_begin();
+    history_add(to_ms_since_boot(get_absolute_time()), temperature, humidity, pressure); // Lido por /export, no contexto do lwIP
+    for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+        struct http_conn *c = &conns[i];
+
+        bool ok;
+        if (c->kind == CONN_WS) {
+            ok = stream_send(c, frame, sizeof(frame));
+            if (ok) {
+                ws_frames_sent++;
+                ws_bytes_sent += sizeof(frame);
+            }
+        } else if (c->kind == CONN_SSE) {
+            ok = stream_send(c, ev, ev_len);
+        } else {
+            continue;
+        }
+
+        if (ok) {
+            tcp_output(c->pcb);
+        } else {
+            conn_drop(c);
+        }
+    }
+    cyw43_arch_lwip_end();
+}
+
+
+
+// ======== REQUISIÇÕES HTTP ===========
+
+/**
+ * Acrescenta texto formatado em buf, que já tem n caracteres, e retorna o novo tamanho. Como
+ * metrics_printf, para de acrescentar quando o buffer enche: o resultado nunca passa de size - 1.
+ */
+static size_t http_append(char *buf, size_t size, size_t n, const char *fmt, ...) {
+    if (n + 1 >= size) return n;
+
+    va_list args;
+    va_start(args, fmt);
+    int r = vsnprintf(buf + n, size - n, fmt, args);
+    va_end(args);
+
+    if (r < 0) return n;
+    return (size_t)r >= size - n ? size - 1 : n + r;
+}
+
+// Responde com a configuração ativa
+static void http_handle_config(struct http_conn *c, const http_parser_t *req) {
+    config_t cfg;
+    config_get(&config, &cfg);
+
+    char json[160];
+    size_t n = http_append(json, sizeof(json), 0, "{\"versao\":%lu", (unsigned long)cfg.version);
+    for (int i = 0; i < CONFIG_NUM_CHANNELS; i++) {
+        n = http_append(json, sizeof(json), n, ",\"%s\":{\"min\":%.2f,\"max\":%.2f}",
+                        config_channel_name(i), cfg.limits[i].min, cfg.limits[i].max);
+    }
+    n = http_append(json, sizeof(json), n, "}");
+
+    http_respond(c, "200 OK", "application/json", json, n);
+}
+
+/**
+ * Lê um limite da query. Retorna 1 se o valor foi lido, 0 se o parâmetro não existe ou está vazio
+ * e -1 se o valor não é um número.
+ */
+static int http_query_limit(const http_parser_t *req, const char *key, float *out) {
+    char valor[24];
+    if (!http_query_get(req, key, valor, sizeof(valor)) || !valor[0]) return 0;
+
+    char *fim;
+    float v = strtof(valor, &fim);
+    if (*fim != '\0') return -1;
+    *out = v;
+    return 1;
+}
+
+/**
+ * Altera os limites de qualquer conjunto de canais em uma única requisição (temp_min, temp_max,
+ * hum_min, ..., ou tipo/min/max para um canal) e responde com a configuração resultante. Canais
+ * omitidos mantêm os limites atuais. A nova configuração é validada e publicada inteira, ou recusada.
+ */
+static void http_handle_limites(struct http_conn *c, const http_parser_t *req) {
+    config_t cfg;
+    config_get(&config, &cfg);
+
+    char chave[16];
+    int lidos = 0;
+    bool invalido = false;
+
+    for (int i = 0; i < CONFIG_NUM_CHANNELS; i++) {
+        for (int k = 0; k < 2; k++) {
+            snprintf(chave, sizeof(chave), "%s_%s", config_channel_name(i), k ? "max" : "min");
+            int r = http_query_limit(req, chave, k ? &cfg.limits[i].max : &cfg.limits[i].min);
+            if (r < 0) invalido = true;
+            if (r > 0) lidos++;
+        }
+    }
+
+    // Formato anterior: um canal por requisição
+    if (http_query_get(req, "tipo", chave, sizeof(chave))) {
+        int i = 0;
+        while (i < CONFIG_NUM_CHANNELS && strcmp(chave, config_channel_name(i)) != 0) i++;
+        if (i == CONFIG_NUM_CHANNELS) {
+            invalido = true;
+        } else {
+            int r_min = http_query_limit(req, "min", &cfg.limits[i].min);
+            int r_max = http_query_limit(req, "max", &cfg.limits[i].max);
+            if (r_min < 0 || r_max < 0) invalido = true;
+            lidos += (r_min > 0) + (r_max > 0);
+        }
+    }
+
+    const char *erro = "valor invalido";
+    if (invalido || (lidos && !config_update(&config, &cfg, &erro))) {
+        char json[64];
+        size_t n = snprintf(json, sizeof(json), "{\"erro\":\"%s\"}", erro);
+        http_respond(c, "400 Bad Request", "application/json", json, n);
+        return;
+    }
+
+    http_handle_config(c, req);
+}
+
+static void http_handle_estado(struct http_conn *c, const http_parser_t *req) {
+    // Último número de sequência visto pelo cliente. Sem o parâmetro, envia todo o histórico
+    uint32_t since = 0;
+    http_query_get_u32(req, "since", &since);
+
+    // Quantas amostras novas existem desde "since", limitado ao que ainda está no buffer.
+    // Um "since" maior que o atual indica que a placa reiniciou: reenvia tudo
+    webserver_samples_t a;
+    seqlatch_read(&amostras, &a);
+    uint32_t seq = a.seq;
+    uint32_t disponiveis = seq < MAX_BUFFER_SIZE ? seq : MAX_BUFFER_SIZE;
+    uint32_t novas = (since > seq) ? seq : seq - since;
+    if (novas > disponiveis) novas = disponiveis;
+
+    char json_payload[1024];
+    size_t n = http_append(json_payload, sizeof(json_payload), 0, "{\"seq\":%lu", (unsigned long)seq);
+
+    const char *chaves[3] = {"temperaturas", "umidades", "pressoes"};
+    const float *buffers[3] = {a.temperature, a.humidity, a.pressure};
+
+    for (int k = 0; k < 3; k++) {
+        n = http_append(json_payload, sizeof(json_payload), n, ",\"%s\":[", chaves[k]);
+        for (uint32_t s = seq - novas; s != seq; s++) {
+            n = http_append(json_payload, sizeof(json_payload), n, "%s%.2f",
+                            (s != seq - novas) ? "," : "", buffers[k][s % MAX_BUFFER_SIZE]);
+        }
+        n = http_append(json_payload, sizeof(json_payload), n, "]");
+    }
+    n = http_append(json_payload, sizeof(json_payload), n, "}");
+
+    http_respond(c, "200 OK", "application/json", json_payload, n);
+}
+
+/**
+ * Lista as regras de alarme. Com add=<regra>, del=<id> ou clear=1, altera a lista antes.
+ * Roda no contexto do lwIP; o laço principal avalia as regras com o lwIP bloqueado.
+ */
+static void http_handle_regras(struct http_conn *c, const http_parser_t *req) {
+    static char json[RULES_MAX * (RULES_TEXT_MAX + 40) + 32];
+    char texto[RULES_TEXT_MAX];
+    uint32_t id;
+    size_t n;
+
+    if (http_query_get(req, "add", texto, sizeof(texto))) {
+        const char *erro = "regra invalida";
+        if (rules_add(&regras, texto, &erro) < 0) {
+            n = snprintf(json, sizeof(json), "{\"erro\":\"%s\"}", erro);
+            http_respond(c, "400 Bad Request", "application/json", json, n);
+            return;
+        }
+    } else if (http_query_get_u32(req, "del", &id)) {
+        rules_remove(&regras, (uint16_t)id);
+    } else if (http_query_get(req, "clear", texto, sizeof(texto))) {
+        rules_clear(&regras);
     }
 
-    char *req = (char *)p->payload;
+    n = http_append(json, sizeof(json), 0, "{\"regras\":[");
+    for (uint16_t i = 0; i < regras.num_rules; i++) {
+        const rules_rule_t *r = &regras.rules[i];
+        n = http_append(json, sizeof(json), n, "%s{\"id\":%u,\"regra\":\"", i ? "," : "", r->id);
+        size_t w = rules_format(&regras, r, json + n, sizeof(json) - n);
+        n = (n + w < sizeof(json)) ? n + w : sizeof(json) - 1;
+        n = http_append(json, sizeof(json), n, "\",\"ativa\":%s}", r->active ? "true" : "false");
+    }
+    n = http_append(json, sizeof(json), n, "]}");
 
-    if (strstr(req, "GET /limites")) {
-        struct http_state *hs = malloc(sizeof(struct http_state));
-        if (!hs) return ERR_MEM;
-        hs->sent = 0;
+    http_respond(c, "200 OK", "application/json", json, n);
+}
 
-        char *tipo_str = strstr(req, "tipo=");
-        char *min_str = strstr(req, "min=");
-        char *max_str = strstr(req, "max=");
+#if PROF_ENABLED
+// Tabela com o tempo das etapas do laço principal. Com reset=1, zera as medidas depois de montar a resposta
+static void http_handle_prof(struct http_conn *c, const http_parser_t *req) {
+    static char tabela[PROF_TEXT_MAX];
+    size_t n = prof_format(tabela, sizeof(tabela));
 
-        if (tipo_str && min_str && max_str) {
-            char tipo[6] = {0};
-            float min_val = 0.0, max_val = 0.0;
+    char reset[4];
+    if (http_query_get(req, "reset", reset, sizeof(reset))) {
+        prof_reset();
+    }
+    http_respond(c, "200 OK", "text/plain", tabela, n);
+}
+#endif
 
-            sscanf(tipo_str, "tipo=%5[^& \r\n]", tipo);
-            sscanf(min_str, "min=%f", &min_val);
-            sscanf(max_str, "max=%f", &max_val);
+// Uso das pilhas, do heap e dos pools do lwIP
+static void http_handle_mem(struct http_conn *c, const http_parser_t *req) {
+    static char relatorio[MEMSTATS_TEXT_MAX];
+    size_t n = memstats_format(relatorio, sizeof(relatorio));
+    http_respond(c, "200 OK", "text/plain", relatorio, n);
+}
+
+/**
+ * Métricas no formato de texto do Prometheus. O corpo é gerado aos poucos pelos coletores registrados,
+ * em pedaços (chunked), sem montar a resposta inteira na memória.
+ */
+static void http_handle_metrics(struct http_conn *c, const http_parser_t *req) {
+    // HTTP/1.0 não tem chunked: o fim do corpo é indicado pelo fechamento da conexão
+    c->tx_chunked = req->flags & HTTP_FLAG_HTTP11;
+    if (!c->tx_chunked) c->keep_alive = false;
+
+    char header[192];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4\r\n"
+                       "%s"
+                       "%s\r\n",
+                       c->tx_chunked ? "Transfer-Encoding: chunked\r\n" : "", http_connection_header(c));
+    tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+
+    c->tx_metrics = 0;
+    c->tx_us = 0;
+    http_send_metrics(c);
+}
+
+/**
+ * Lê um instante da query em segundos desde o boot; um valor negativo conta para trás a partir de
+ * agora. Retorna 1 se o valor foi lido, 0 se o parâmetro não existe e -1 se ele não é um número.
+ */
+static int http_query_time(const http_parser_t *req, const char *key, uint32_t agora_s, uint32_t *out) {
+    char valor[16];
+    if (!http_query_get(req, key, valor, sizeof(valor)) || !valor[0]) return 0;
+
+    char *fim;
+    long long v = strtoll(valor, &fim, 10);
+    if (*fim != '\0') return -1;
+    // Módulo de v em aritmética sem sinal: -v estoura com v == LLONG_MIN
+    unsigned long long modulo = v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v;
+    if (v < 0) {
+        *out = modulo > agora_s ? 0 : agora_s - (uint32_t)modulo;
+    } else {
+        *out = modulo > UINT32_MAX ? UINT32_MAX : (uint32_t)modulo;
+    }
+    return 1;
+}
 
-            if (strcmp(tipo, "temp") == 0) {
-                temp_min_user = min_val;
-                temp_max_user = max_val;
-            } else if (strcmp(tipo, "hum") == 0) {
-                hum_min_user = min_val;
-                hum_max_user = max_val;
-            } else if (strcmp(tipo, "press") == 0) {
-                press_min_user = min_val;
-                press_max_user = max_val;
+/**
+ * Histórico de longo prazo em CSV ou NDJSON: from e to em segundos desde o boot (negativos contam a
+ * partir de agora), step em segundos (arredondado para um múltiplo de HISTORY_PERIOD_S; cada linha é
+ * a média dos períodos do passo) e format csv ou ndjson. O corpo sai em pedaços (chunked), gerados
+ * do histórico conforme a conexão esvazia. X-Uptime permite converter os instantes em data e hora.
+ */
+static void http_handle_export(struct http_conn *c, const http_parser_t *req) {
+    uint32_t agora_s = to_ms_since_boot(get_absolute_time()) / 1000;
+    uint32_t de = 0, ate = agora_s, passo = HISTORY_PERIOD_S;
+    char formato[8] = "csv";
+
+    http_query_get(req, "format", formato, sizeof(formato));
+    bool csv = strcmp(formato, "csv") == 0;
+    bool invalido = !csv && strcmp(formato, "ndjson") != 0;
+    if (http_query_time(req, "from", agora_s, &de) < 0) invalido = true;
+    if (http_query_time(req, "to", agora_s, &ate) < 0) invalido = true;
+    http_query_get_u32(req, "step", &passo);
+    if (passo < HISTORY_PERIOD_S || passo / HISTORY_PERIOD_S > UINT16_MAX || de > ate) invalido = true;
+
+    if (invalido) {
+        const char *json = "{\"erro\":\"parametro invalido\"}";
+        http_respond(c, "400 Bad Request", "application/json", json, strlen(json));
+        return;
+    }
+
+    // Intervalo em períodos do histórico, limitado ao que ainda está no anel. O início avança em
+    // passos inteiros para as linhas continuarem alinhadas ao from pedido
+    uint32_t passo_p = passo / HISTORY_PERIOD_S;
+    uint32_t inicio = de / HISTORY_PERIOD_S;
+    uint32_t fim = ate / HISTORY_PERIOD_S + 1;
+    if (fim > history_end()) fim = history_end();
+    if (inicio < history_first()) inicio += (history_first() - inicio) / passo_p * passo_p;
+
+    // HTTP/1.0 não tem chunked: o fim do corpo é indicado pelo fechamento da conexão
+    c->tx_chunked = req->flags & HTTP_FLAG_HTTP11;
+    if (!c->tx_chunked) c->keep_alive = false;
+
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: %s\r\n"
+                       "Content-Disposition: attachment; filename=\"historico.%s\"\r\n"
+                       "X-Uptime: %lu\r\n"
+                       "%s"
+                       "%s\r\n",
+                       csv ? "text/csv" : "application/x-ndjson", csv ? "csv" : "ndjson",
+                       (unsigned long)agora_s,
+                       c->tx_chunked ? "Transfer-Encoding: chunked\r\n" : "", http_connection_header(c));
+    if (tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK) {
+        // Sem a linha de status, o corpo não pode ser enviado: encerra a conexão, como http_respond
+        c->keep_alive = false;
+        return;
+    }
+
+    c->tx_export = csv ? EXPORT_CSV_HEADER : EXPORT_NDJSON;
+    c->export_step = passo_p;
+    c->export_next = inicio;
+    c->export_end = fim;
+    http_send_export(c);
+}
+
+// ETag da página: hash FNV-1a do conteúdo, calculado uma única vez
+static const char *http_page_etag(void) {
+    static char etag[12];
+    if (!etag[0]) {
+        uint32_t h = 2166136261u;
+        for (unsigned i = 0; i < HTML_NUM_PARTS; i++) {
+            for (uint16_t j = 0; j < HTML_PART_LENS[i]; j++) {
+                h = (h ^ (uint8_t)HTML_PARTS[i][j]) * 16777619u;
             }
         }
+        snprintf(etag, sizeof(etag), "%08lx", (unsigned long)h);
+    }
+    return etag;
+}
+
+static void http_handle_page(struct http_conn *c, const http_parser_t *req) {
+    const char *etag = http_page_etag();
+
+    // O navegador já tem esta versão da página
+    if (strcmp(req->etag, etag) == 0) {
+        char header[160];
+        int len = snprintf(header, sizeof(header),
+                           "HTTP/1.1 304 Not Modified\r\n"
+                           "ETag: \"%s\"\r\n"
+                           "%s\r\n",
+                           etag, http_connection_header(c));
+        tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY);
+        tcp_output(c->pcb);
+        return;
+    }
+
+    uint32_t total = 0;
+    for (unsigned i = 0; i < HTML_NUM_PARTS; i++) {
+        total += HTML_PART_LENS[i];
+    }
+
+    char header[192];
+    int len = snprintf(header, sizeof(header),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/html\r\n"
+                       "Content-Length: %lu\r\n"
+                       "ETag: \"%s\"\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "%s\r\n",
+                       (unsigned long)total, etag, http_connection_header(c));
+
+    if (req->method == HTTP_METHOD_HEAD) {
+        tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY);
+        tcp_output(c->pcb);
+        return;
+    }
+    tcp_write(c->pcb, header, len, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+
+    c->tx_part = 0;
+    c->tx_offset = 0;
+    http_send_page(c);
+}
+
+typedef void (*http_handler_t)(struct http_conn *c, const http_parser_t *req);
+
+struct http_route {
+    const char *path;
+    http_handler_t handler;
+    bool allow_head; // Aceita HEAD além de GET
+};
+
+static const struct http_route routes[] = {
+    {"/",           http_handle_page,    true},
+    {"/index.html", http_handle_page,    true},
+    {"/estado",     http_handle_estado,  false},
+    {"/config",     http_handle_config,  false},
+    {"/limites",    http_handle_limites, false},
+    {"/regras",     http_handle_regras,  false},
+    {"/metrics",    http_handle_metrics, false},
+    {"/mem",        http_handle_mem,     false},
+    {"/export",     http_handle_export,  false},
+#if PROF_ENABLED
+    {"/prof",       http_handle_prof,    false},
+#endif
+    {"/eventos",    sse_accept,          false},
+    {"/ws",         ws_accept,           false},
+};
+
+#define HTTP_NUM_ROUTES (sizeof(routes) / sizeof(routes[0]))
+static uint32_t route_requests[HTTP_NUM_ROUTES]; // Requisições atendidas por rota
+
+static const char *http_status_text(uint16_t status) {
+    switch (status) {
+        case 404: return "404 Not Found";
+        case 405: return "405 Method Not Allowed";
+        case 414: return "414 URI Too Long";
+        case 505: return "505 HTTP Version Not Supported";
+        default:  return "400 Bad Request";
+    }
+}
+
+// Encaminha a requisição completa para o handler da rota
+static void http_dispatch(struct http_conn *c, const http_parser_t *req) {
+    // HTTP/1.1 mantém a conexão por padrão; HTTP/1.0 só com "Connection: keep-alive"
+    c->keep_alive = (req->flags & HTTP_FLAG_HTTP11)
+        ? !(req->flags & HTTP_FLAG_CONN_CLOSE)
+        : (req->flags & HTTP_FLAG_CONN_KEEPALIVE);
+
+    for (unsigned i = 0; i < HTTP_NUM_ROUTES; i++) {
+        if (!http_path_is(req, routes[i].path)) continue;
+
+        if (req->method == HTTP_METHOD_GET || (req->method == HTTP_METHOD_HEAD && routes[i].allow_head)) {
+            route_requests[i]++;
+            routes[i].handler(c, req);
+        } else {
+            http_refused++;
+            http_respond_status(c, http_status_text(405));
+        }
+        return;
+    }
 
-        const char *redir_hdr = "HTTP/1.1 302 Found\r\nLocation: /\r\n\r\n";
-        hs->len = snprintf(hs->response, sizeof(hs->response), redir_hdr);
+    http_not_found++;
+    http_respond(c, http_status_text(404), "text/plain", "", 0);
+}
 
-        tcp_arg(tpcb, hs);
-        tcp_sent(tpcb, http_sent);
-        tcp_write(tpcb, hs->response, hs->len, TCP_WRITE_FLAG_COPY);
-        tcp_output(tpcb);
+// Coletor de /metrics do servidor. Roda no contexto do lwIP, junto com os contadores que lê
+static void http_collect(metrics_writer_t *w, unsigned part) {
+    static const char *const tipos[] = { [CONN_HTTP] = "tipo=\"http\"", [CONN_SSE] = "tipo=\"sse\"", [CONN_WS] = "tipo=\"ws\"" };
+    char labels[32];
+
+    switch (part) {
+    case 0:
+        metrics_family(w, "station_http_requests_total", "counter", "Requisicoes HTTP atendidas por rota");
+        for (unsigned i = 0; i < HTTP_NUM_ROUTES; i++) {
+            snprintf(labels, sizeof(labels), "path=\"%s\"", routes[i].path);
+            metrics_uint(w, "station_http_requests_total", labels, route_requests[i]);
+        }
+        metrics_family(w, "station_http_errors_total", "counter", "Requisicoes HTTP recusadas");
+        metrics_uint(w, "station_http_errors_total", "motivo=\"not_found\"", http_not_found);
+        metrics_uint(w, "station_http_errors_total", "motivo=\"invalida\"", http_refused);
+        break;
+
+    case 1: {
+        uint32_t ativas[CONN_WS + 1] = { 0 };
+        for (int i = 0; i < HTTP_MAX_CONNS; i++) {
+            ativas[conns[i].kind]++;
+        }
+        metrics_family(w, "station_http_connections", "gauge", "Conexoes abertas por tipo");
+        for (int k = CONN_HTTP; k <= CONN_WS; k++) {
+            metrics_uint(w, "station_http_connections", tipos[k], ativas[k]);
+        }
+        metrics_family(w, "station_http_connections_rejected_total", "counter", "Conexoes recusadas com o pool cheio");
+        metrics_uint(w, "station_http_connections_rejected_total", NULL, conns_rejected);
+        metrics_family(w, "station_stream_dropped_total", "counter", "Clientes de /eventos e /ws descartados por lentidao");
+        metrics_uint(w, "station_stream_dropped_total", NULL, stream_dropped);
+        metrics_family(w, "station_ws_frames_sent_total", "counter", "Quadros de amostra enviados via WebSocket");
+        metrics_uint(w, "station_ws_frames_sent_total", NULL, ws_frames_sent);
+        metrics_family(w, "station_ws_bytes_sent_total", "counter", "Bytes dos quadros de amostra enviados via WebSocket");
+        metrics_uint(w, "station_ws_bytes_sent_total", NULL, ws_bytes_sent);
+        metrics_family(w, "station_scrapes_total", "counter", "Leituras completas de /metrics");
+        metrics_uint(w, "station_scrapes_total", NULL, metrics_scrapes);
+        metrics_family(w, "station_scrape_truncated_total", "counter", "Partes de /metrics que nao couberam no pedaco");
+        metrics_uint(w, "station_scrape_truncated_total", NULL, metrics_truncated);
+        break;
     }
 
-    else if (strstr(req, "GET /estado")) {
-        struct http_state *hs = malloc(sizeof(struct http_state));
-        if (!hs) return ERR_MEM;
-        hs->sent = 0;
+    default:
+        metrics_histogram(w, "station_scrape_duration_us", "Tempo de CPU gasto gerando /metrics", &metrics_scrape_us);
+        break;
+    }
+}
+
+/**
+ * Alimenta o parser com cada pbuf da cadeia, lendo o payload no próprio lugar,
+ * e atende cada requisição assim que ela termina.
+ */
+static err_t http_recv_chain(struct http_conn *c, struct pbuf *p) {
+    for (struct pbuf *q = p; q; q = q->next) {
+        const char *data = (const char *)q->payload;
+        size_t len = q->len;
+
+        while (len > 0) {
+            // Após o upgrade para /eventos ou /ws, o restante não é mais HTTP
+            if (c->kind != CONN_HTTP) return ERR_OK;
 
-        char temp_str[512] = "", hum_str[512] = "", press_str[512] = "";
+            // Requisição em pipeline enquanto a página ainda está sendo enviada: fecha ao terminar, o cliente a repete
+            if (http_sending(c)) {
+                c->keep_alive = false;
+                return ERR_OK;
+            }
 
-        for (int i = 0; i < MAX_BUFFER_SIZE; i++) {
-            int idx = (buffer_index + i) % MAX_BUFFER_SIZE;
+            size_t used = http_parser_feed(&c->parser, data, len);
+            data += used;
+            len -= used;
 
-            snprintf(temp_str + strlen(temp_str), sizeof(temp_str) - strlen(temp_str),
-                     "%.2f%s", temp_buffer[idx], (i < MAX_BUFFER_SIZE - 1) ? "," : "");
+            if (http_parser_failed(&c->parser)) {
+                http_refused++;
+                http_respond_status(c, http_status_text(c->parser.error));
+                return conn_close(c);
+            }
 
-            snprintf(hum_str + strlen(hum_str), sizeof(hum_str) - strlen(hum_str),
-                     "%.2f%s", hum_buffer[idx], (i < MAX_BUFFER_SIZE - 1) ? "," : "");
+            if (http_parser_done(&c->parser)) {
+                http_dispatch(c, &c->parser);
+                if (c->kind != CONN_HTTP) return ERR_OK;
 
-            snprintf(press_str + strlen(press_str), sizeof(press_str) - strlen(press_str),
-                     "%.2f%s", press_buffer[idx], (i < MAX_BUFFER_SIZE - 1) ? "," : "");
+                if (!c->keep_alive) {
+                    return http_sending(c) ? ERR_OK : conn_close(c);
+                }
+                http_parser_init(&c->parser);
+            }
         }
+    }
+    return ERR_OK;
+}
+
+static err_t http_recv(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err) {
+    struct http_conn *c = (struct http_conn *)arg;
+
+    if (!p) { // Cliente fechou a conexão
+        return conn_close(c);
+    }
 
-        char json_payload[2048];
-        snprintf(json_payload, sizeof(json_payload),
-                 "{\"temperaturas\":[%s],\"umidades\":[%s],\"pressoes\":[%s]}",
-                 temp_str, hum_str, press_str);
-
-        hs->len = snprintf(hs->response, sizeof(hs->response),
-                           "HTTP/1.1 200 OK\r\n"
-                           "Content-Type: application/json\r\n"
-                           "Content-Length: %d\r\n"
-                           "Connection: close\r\n\r\n%s",
-                           (int)strlen(json_payload), json_payload);
-
-        tcp_arg(tpcb, hs);
-        tcp_sent(tpcb, http_sent);
-        tcp_write(tpcb, hs->response, hs->len, TCP_WRITE_FLAG_COPY);
-        tcp_output(tpcb);
-    }
-
-    else {
-        const char* header =
-            "HTTP/1.1 200 OK\r\n"
-            "Content-Type: text/html\r\n"
-            "Connection: close\r\n\r\n";
-
-        tcp_write(tpcb, header, strlen(header), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART1, strlen(HTML_PART1), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART2, strlen(HTML_PART2), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART3, strlen(HTML_PART3), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART4, strlen(HTML_PART4), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART5, strlen(HTML_PART5), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART6, strlen(HTML_PART6), TCP_WRITE_FLAG_COPY);
-        tcp_write(tpcb, HTML_PART7, strlen(HTML_PART7), TCP_WRITE_FLAG_COPY);
-        tcp_output(tpcb);
+    // Ainda enviando a resposta anterior: o lwIP guarda a requisição e a entrega de novo depois
+    if (c->kind == CONN_HTTP && http_sending(c)) {
+        return ERR_MEM;
+    }
+
+    c->idle = 0;
+    tcp_recved(tpcb, p->tot_len);
+
+    err_t ret = ERR_OK;
+    if (c->kind == CONN_HTTP) {
+        ret = http_recv_chain(c, p);
+    } else if (c->kind == CONN_WS) {
+        ret = ws_recv(c, p);
     }
 
     pbuf_free(p);
+    return ret;
+}
+
+static err_t http_sent(void *arg, struct tcp_pcb *tpcb, u16_t len) {
+    struct http_conn *c = (struct http_conn *)arg;
+    c->idle = 0;
+
+    if (c->kind != CONN_HTTP) {
+        c->backlog = (len >= c->backlog) ? 0 : c->backlog - len;
+        return ERR_OK;
+    }
+
+    if (http_sending(c)) {
+        http_send_pending(c);
+        if (!http_sending(c) && !c->keep_alive) {
+            return conn_close(c);
+        }
+    }
     return ERR_OK;
 }
 
+// Chamado a cada HTTP_POLL_INTERVAL: encerra conexões keep-alive ociosas e retoma envios pendentes
+static err_t http_poll(void *arg, struct tcp_pcb *tpcb) {
+    struct http_conn *c = (struct http_conn *)arg;
+    if (c->kind != CONN_HTTP) return ERR_OK;
 
+    if (http_sending(c)) {
+        http_send_pending(c);
+        return ERR_OK;
+    }
 
-static err_t connection_callback(void *arg, struct tcp_pcb *newpcb, err_t err) {
-    tcp_recv(newpcb, http_recv);
+    if (++c->idle >= HTTP_IDLE_TIMEOUT_S) {
+        return conn_close(c);
+    }
     return ERR_OK;
 }
 
-static void start_http_server(void) {
-    struct tcp_pcb *pcb = tcp_new();
-    tcp_bind(pcb, IP_ADDR_ANY, 80);
-    pcb = tcp_listen(pcb);
-    tcp_accept(pcb, connection_callback);
-    printf("Servidor HTTP iniciado na porta 80\n");
+static void http_error(void *arg, err_t err) {
+    // O pcb já foi liberado pelo lwIP; só devolve o estado ao pool
+    struct http_conn *c = (struct http_conn *)arg;
+    if (c) {
+        c->pcb = NULL;
+        c->kind = CONN_FREE;
+    }
 }
 
-bool webserver_init(void) {
-    if (cyw43_arch_init()) {
-        printf("Falha para iniciar o cyw43\n");
-        return false;
+static err_t connection_callback(void *arg, struct tcp_pcb *newpcb, err_t err) {
+    if (err != ERR_OK || !newpcb) return ERR_VAL;
+
+    struct http_conn *c = conn_alloc();
+    if (!c) { // Pool esgotado: recusa a conexão
+        conns_rejected++;
+        tcp_abort(newpcb);
+        return ERR_ABRT;
     }
 
-    cyw43_arch_enable_sta_mode();
+    memset(c, 0, offsetof(struct http_conn, parser));
+    c->pcb = newpcb;
+    c->kind = CONN_HTTP;
+    c->tx_part = HTML_NUM_PARTS;
+    c->tx_metrics = -1;
+    http_parser_init(&c->parser);
+
+    tcp_arg(newpcb, c);
+    tcp_recv(newpcb, http_recv);
+    tcp_sent(newpcb, http_sent);
+    tcp_err(newpcb, http_error);
+    tcp_poll(newpcb, http_poll, HTTP_POLL_INTERVAL);
+    return ERR_OK;
+}
 
-    printf("Conectando ao Wi-Fi: %s\n", WIFI_SSID);
-    if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK, 15000)) {
-        printf("Falha para conectar ao Wi-Fi\n");
-        cyw43_arch_deinit();
+bool webserver_init(void) {
+    cyw43_arch_lwip_begin();
+    struct tcp_pcb *pcb = tcp_new();
+    if (!pcb || tcp_bind(pcb, IP_ADDR_ANY, 80) != ERR_OK) {
+        if (pcb) tcp_close(pcb);
+        cyw43_arch_lwip_end();
+        printf("Falha para iniciar o servidor HTTP\n");
         return false;
     }
+    pcb = tcp_listen(pcb);
+    tcp_accept(pcb, connection_callback);
+    cyw43_arch_lwip_end();
 
-    printf("Conectado com sucesso!\n");
-    start_http_server();
+    metrics_register(http_collect, 3);
+    printf("Servidor HTTP iniciado na porta 80\n");
     return true;
-}                                                
+}
@@ -2,7 +2,26 @@
 #define WEBSERVER_H
 
 #include <stdbool.h> 
+#include <stdint.h>
 
+#define WEBSERVER_MAX_SAMPLES 20 // Amostras recentes mantidas para /estado e para a retomada de /eventos
+
+// Amostras recentes publicadas pelo laço principal. A amostra de número s fica no índice (s - 1) % WEBSERVER_MAX_SAMPLES
+typedef struct {
+    uint32_t seq; // Número da amostra mais recente
+    float temperature[WEBSERVER_MAX_SAMPLES];
+    float humidity[WEBSERVER_MAX_SAMPLES];
+    float pressure[WEBSERVER_MAX_SAMPLES];
+} webserver_samples_t;
+
+// Abre a porta 80. Não depende do Wi-Fi: as conexões chegam assim que a interface tiver IP (wifi.h)
 bool webserver_init(void);
 
+/**
+ * Grava a nova amostra no histórico, publicando-o por inteiro para os handlers HTTP, acumula-a no
+ * histórico de longo prazo de /export (history.h) e a envia aos clientes conectados em /eventos e
+ * /ws. Chamada apenas pelo laço principal.
+ */
+void webserver_publish_sample(uint32_t seq, float temperature, float humidity, float pressure);
+
 #endif // WEBSERVER_H
\ No newline at end of file
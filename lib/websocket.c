@@ -0,0 +1,110 @@
+#include <math.h>
+#include <string.h>
+
+#include "sha1.h"
+#include "websocket.h"
+
+static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static const char BASE64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_SIZE]) {
+    uint8_t digest[SHA1_DIGEST_SIZE];
+    sha1_ctx_t ctx;
+    sha1_init(&ctx);
+    sha1_update(&ctx, key, key_len);
+    sha1_update(&ctx, WS_GUID, strlen(WS_GUID));
+    sha1_final(&ctx, digest);
+
+    // Base64 dos 20 bytes: 6 grupos completos de 3 bytes + 2 bytes com um '=' de preenchimento
+    char *o = out;
+    for (int i = 0; i < SHA1_DIGEST_SIZE; i += 3) {
+        uint32_t v = (uint32_t)digest[i] << 16;
+        if (i + 1 < SHA1_DIGEST_SIZE) v |= (uint32_t)digest[i + 1] << 8;
+        if (i + 2 < SHA1_DIGEST_SIZE) v |= digest[i + 2];
+
+        *o++ = BASE64[(v >> 18) & 0x3F];
+        *o++ = BASE64[(v >> 12) & 0x3F];
+        *o++ = (i + 1 < SHA1_DIGEST_SIZE) ? BASE64[(v >> 6) & 0x3F] : '=';
+        *o++ = (i + 2 < SHA1_DIGEST_SIZE) ? BASE64[v & 0x3F] : '=';
+    }
+    *o = '\0';
+}
+
+size_t ws_frame_header(uint8_t *out, uint8_t opcode, size_t payload_len) {
+    out[0] = 0x80 | (opcode & 0x0F);
+    if (payload_len < 126) {
+        out[1] = (uint8_t)payload_len;
+        return 2;
+    }
+    out[1] = 126;
+    out[2] = (uint8_t)(payload_len >> 8);
+    out[3] = (uint8_t)payload_len;
+    return 4;
+}
+
+void ws_close_frame(uint8_t *frame, uint16_t code) {
+    ws_frame_header(frame, WS_OPCODE_CLOSE, 2);
+    frame[2] = (uint8_t)(code >> 8); // Big-endian, como os tamanhos do cabeçalho
+    frame[3] = (uint8_t)code;
+}
+
+static void put_u32_le(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_u16_le(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+void ws_encode_sample(uint8_t *frame, uint32_t seq, uint32_t timestamp_ms,
+                      float temperature, float humidity, float pressure) {
+    uint8_t *p = frame + ws_frame_header(frame, WS_OPCODE_BINARY, WS_SAMPLE_PAYLOAD_SIZE);
+
+    put_u32_le(p + 0, seq);
+    put_u32_le(p + 4, timestamp_ms);
+    put_u16_le(p + 8, (uint16_t)(int16_t)lroundf(temperature * 100.0f));
+    put_u16_le(p + 10, (uint16_t)(int16_t)lroundf(humidity * 100.0f));
+    put_u32_le(p + 12, (uint32_t)(int32_t)lroundf(pressure * 1000.0f)); // kPa -> Pa
+}
+
+size_t ws_decode_frame(uint8_t *buf, size_t len, uint8_t *opcode, uint8_t **payload, size_t *payload_len) {
+    if (len < 2) return 0;
+
+    *opcode = buf[0] & 0x0F;
+    bool masked = buf[1] & 0x80;
+    size_t plen = buf[1] & 0x7F;
+    size_t pos = 2;
+
+    if (plen == 126) {
+        if (len < 4) return 0;
+        plen = ((size_t)buf[2] << 8) | buf[3];
+        pos = 4;
+    } else if (plen == 127) {
+        // Quadros de 64 bits não são esperados de um painel; consome o buffer inteiro
+        *payload = NULL;
+        *payload_len = 0;
+        *opcode = WS_OPCODE_CLOSE;
+        return len;
+    }
+
+    uint8_t mask[4] = {0};
+    if (masked) {
+        if (len < pos + 4) return 0;
+        memcpy(mask, buf + pos, 4);
+        pos += 4;
+    }
+    if (len < pos + plen) return 0;
+
+    for (size_t i = 0; i < plen; i++) {
+        buf[pos + i] ^= mask[i & 3];
+    }
+
+    *payload = buf + pos;
+    *payload_len = plen;
+    return pos + plen;
+}
@@ -0,0 +1,54 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Opcodes do RFC 6455
+#define WS_OPCODE_CONT   0x0
+#define WS_OPCODE_TEXT   0x1
+#define WS_OPCODE_BINARY 0x2
+#define WS_OPCODE_CLOSE  0x8
+#define WS_OPCODE_PING   0x9
+#define WS_OPCODE_PONG   0xA
+
+// Códigos de encerramento do RFC 6455 usados pelo servidor
+#define WS_CLOSE_PROTOCOL_ERROR 1002 // Quadro do cliente sem máscara
+#define WS_CLOSE_TOO_BIG        1009 // Quadro maior que o servidor aceita
+
+#define WS_CLOSE_FRAME_SIZE 4 // Quadro close com código e sem motivo
+
+#define WS_ACCEPT_SIZE 29 // Base64 de 20 bytes (28) + '\0'
+
+/**
+ * Quadro binário de amostra (little-endian, lido com DataView no navegador):
+ *   0  uint32  número de sequência da amostra
+ *   4  uint32  instante da medição em ms desde o boot
+ *   8  int16   temperatura em centésimos de °C
+ *  10  int16   umidade em centésimos de %
+ *  12  int32   pressão em Pa
+ */
+#define WS_SAMPLE_PAYLOAD_SIZE 16
+#define WS_SAMPLE_FRAME_SIZE (2 + WS_SAMPLE_PAYLOAD_SIZE)
+
+// Calcula o Sec-WebSocket-Accept: base64(SHA-1(chave + GUID))
+void ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_SIZE]);
+
+// Monta o cabeçalho de um quadro do servidor (sem máscara, FIN=1). Retorna o tamanho do cabeçalho
+size_t ws_frame_header(uint8_t *out, uint8_t opcode, size_t payload_len);
+
+// Monta em frame[WS_CLOSE_FRAME_SIZE] um quadro close com o código de encerramento
+void ws_close_frame(uint8_t *frame, uint16_t code);
+
+// Monta o quadro binário completo de uma amostra em frame[WS_SAMPLE_FRAME_SIZE]
+void ws_encode_sample(uint8_t *frame, uint32_t seq, uint32_t timestamp_ms,
+                      float temperature, float humidity, float pressure);
+
+/**
+ * Decodifica um quadro do cliente em buf, removendo a máscara no próprio buffer.
+ * Retorna o número de bytes consumidos, ou 0 se o quadro ainda está incompleto.
+ */
+size_t ws_decode_frame(uint8_t *buf, size_t len, uint8_t *opcode, uint8_t **payload, size_t *payload_len);
+
+#endif // WEBSOCKET_H
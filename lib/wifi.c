@@ -0,0 +1,135 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/cyw43_arch.h"
+#include "lwip/netif.h"
+
+#include "events.h"
+#include "metrics.h"
+#include "wifi.h"
+
+#define WIFI_SSID "wifi"
+#define WIFI_PASS "senha"
+
+typedef enum {
+    WIFI_CONECTANDO,  // Tentativa em andamento no cyw43
+    WIFI_CONECTADO,
+    WIFI_ESPERANDO,   // Aguardando a próxima tentativa depois de uma falha
+} wifi_estado_t;
+
+// Só o laço principal mexe no estado; o coletor de /metrics apenas lê contadores de 32 bits
+static bool iniciado = false;                 // cyw43 pronto; sem ele não há o que tentar
+static wifi_estado_t estado = WIFI_ESPERANDO;
+static uint32_t inicio_ms;                    // Início da tentativa atual
+static uint32_t proxima_ms;                   // Próxima tentativa, em WIFI_ESPERANDO
+static uint32_t espera_ms = WIFI_RETRY_MIN_MS;
+static char texto[WIFI_TEXT_MAX] = "Sem WiFi";
+
+static uint32_t conexoes = 0;
+static uint32_t falhas = 0;
+static uint32_t quedas = 0;
+static uint32_t tempo_conexao_ms = 0;         // Duração da última tentativa bem-sucedida
+
+static void falhou(uint32_t agora_ms, int status) {
+    falhas++;
+    cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA); // Cancela o que tiver sobrado da tentativa
+    estado = WIFI_ESPERANDO;
+    proxima_ms = agora_ms + espera_ms;
+    printf("Wi-Fi: falha (%d), nova tentativa em %lu ms\n", status, (unsigned long)espera_ms);
+    espera_ms = espera_ms * 2 > WIFI_RETRY_MAX_MS ? WIFI_RETRY_MAX_MS : espera_ms * 2;
+    snprintf(texto, sizeof(texto), "Sem WiFi");
+}
+
+static void tentar(uint32_t agora_ms) {
+    printf("Conectando ao Wi-Fi: %s\n", WIFI_SSID);
+    inicio_ms = agora_ms;
+    int erro = cyw43_arch_wifi_connect_async(WIFI_SSID, WIFI_PASS, CYW43_AUTH_WPA2_AES_PSK);
+    if (erro) {
+        falhou(agora_ms, erro);
+        return;
+    }
+    estado = WIFI_CONECTANDO;
+    snprintf(texto, sizeof(texto), "Conectando...");
+}
+
+// Contexto do lwIP: só acorda o laço, que confere o estado em wifi_poll
+NETIF_DECLARE_EXT_CALLBACK(aviso_netif)
+static void netif_mudou(struct netif *netif, netif_nsc_reason_t reason, const netif_ext_callback_args_t *args) {
+    if (reason & (LWIP_NSC_LINK_CHANGED | LWIP_NSC_STATUS_CHANGED | LWIP_NSC_IPV4_ADDRESS_CHANGED))
+        events_post(EVENT_NETWORK);
+}
+
+static void wifi_collect(metrics_writer_t *w, unsigned part) {
+    metrics_family(w, "station_wifi_up", "gauge", "Conectado ao Wi-Fi, com IP");
+    metrics_uint(w, "station_wifi_up", NULL, estado == WIFI_CONECTADO);
+    metrics_family(w, "station_wifi_connects_total", "counter", "Conexoes ao Wi-Fi estabelecidas");
+    metrics_uint(w, "station_wifi_connects_total", NULL, conexoes);
+    metrics_family(w, "station_wifi_failures_total", "counter", "Tentativas de conexao sem sucesso");
+    metrics_uint(w, "station_wifi_failures_total", NULL, falhas);
+    metrics_family(w, "station_wifi_disconnects_total", "counter", "Quedas da conexao estabelecida");
+    metrics_uint(w, "station_wifi_disconnects_total", NULL, quedas);
+    metrics_family(w, "station_wifi_connect_ms", "gauge", "Duracao da ultima tentativa bem-sucedida");
+    metrics_uint(w, "station_wifi_connect_ms", NULL, tempo_conexao_ms);
+}
+
+bool wifi_init(void) {
+    if (cyw43_arch_init()) {
+        printf("Falha para iniciar o cyw43\n");
+        return false;
+    }
+
+    cyw43_arch_enable_sta_mode();
+    cyw43_arch_lwip_begin();
+    netif_add_ext_callback(&aviso_netif, netif_mudou);
+    cyw43_arch_lwip_end();
+    iniciado = true;
+    metrics_register(wifi_collect, 1);
+    tentar(to_ms_since_boot(get_absolute_time()));
+    return true;
+}
+
+void wifi_poll(uint32_t agora_ms) {
+    int status;
+    if (!iniciado) return;
+
+    switch (estado) {
+    case WIFI_CONECTANDO:
+        status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+        if (status == CYW43_LINK_UP) {
+            estado = WIFI_CONECTADO;
+            conexoes++;
+            tempo_conexao_ms = agora_ms - inicio_ms;
+            espera_ms = WIFI_RETRY_MIN_MS;
+            cyw43_arch_lwip_begin();
+            snprintf(texto, sizeof(texto), "%s", ip4addr_ntoa(netif_ip4_addr(&cyw43_state.netif[CYW43_ITF_STA])));
+            cyw43_arch_lwip_end();
+            printf("Wi-Fi conectado em %lu ms. IP: %s\n", (unsigned long)tempo_conexao_ms, texto);
+        } else if (status < 0 || agora_ms - inicio_ms > WIFI_ATTEMPT_TIMEOUT_MS) {
+            falhou(agora_ms, status);
+        }
+        break;
+
+    case WIFI_CONECTADO:
+        status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+        if (status != CYW43_LINK_UP) {
+            // Queda da rede: a primeira tentativa é imediata, a espera só cresce se ela falhar
+            quedas++;
+            printf("Wi-Fi: conexao perdida (%d)\n", status);
+            cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+            tentar(agora_ms);
+        }
+        break;
+
+    case WIFI_ESPERANDO:
+        if ((int32_t)(agora_ms - proxima_ms) >= 0) tentar(agora_ms);
+        break;
+    }
+}
+
+bool wifi_connected(void) {
+    return estado == WIFI_CONECTADO;
+}
+
+const char *wifi_text(void) {
+    return texto;
+}
@@ -0,0 +1,30 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WIFI_ATTEMPT_TIMEOUT_MS 20000 // Tempo máximo de uma tentativa de conexão antes de desistir dela
+#define WIFI_RETRY_MIN_MS 1000        // Espera depois da primeira falha; dobra a cada falha seguida
+#define WIFI_RETRY_MAX_MS 60000
+
+#define WIFI_TEXT_MAX 16              // IP ou situação da conexão, com o terminador
+
+/**
+ * Conexão Wi-Fi sem bloqueio. wifi_init liga o cyw43 e dispara a primeira tentativa; dali em diante
+ * wifi_poll, chamada pelo laço principal, acompanha o enlace e, se a tentativa falhar ou a rede
+ * cair, tenta de novo com espera crescente. O servidor HTTP pode ser iniciado antes da conexão:
+ * o lwIP aceita o bind em IP_ADDR_ANY com a interface ainda fora do ar.
+ */
+bool wifi_init(void);
+
+// Mudanças no enlace e no IP postam EVENT_NETWORK; falhas da tentativa e o fim da espera são vistos
+// na próxima chamada, a cada amostra
+void wifi_poll(uint32_t agora_ms);
+
+bool wifi_connected(void);
+
+// IP da placa, ou a situação da conexão enquanto não há IP. Cabe num campo do display
+const char *wifi_text(void);
+
+#endif // WIFI_H
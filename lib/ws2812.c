@@ -0,0 +1,80 @@
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include "ws2812.h"
+#include "ws2812.pio.h"
+
+static void ws2812_start(ws2812_t *ws);
+
+// Fim da transmissão e do reset: libera o driver e envia o quadro pendente, se houver
+static int64_t ws2812_latch_callback(alarm_id_t id, void *user_data) {
+    ws2812_t *ws = (ws2812_t *)user_data;
+
+    ws->busy = false;
+    if (ws->pending)
+        ws2812_start(ws);
+    return 0;
+}
+
+static void ws2812_start(ws2812_t *ws) {
+    // O PIO desloca os bits a partir do mais significativo: GRB nos 24 bits altos
+    for (uint8_t i = 0; i < ws->num_leds; ++i)
+        ws->tx[i] = ws->frame[i] << 8u;
+
+    ws->pending = false;
+    ws->busy = true;
+    ws->frames_sent++;
+
+    dma_channel_transfer_from_buffer_now(ws->dma_chan, ws->tx, ws->num_leds);
+
+    // A DMA termina antes do PIO: conta o tempo do quadro inteiro a partir do início
+    if (add_alarm_in_us(ws->num_leds * WS2812_US_PER_LED + WS2812_RESET_US, ws2812_latch_callback, ws, true) < 0)
+        ws->busy = false; // Sem alarme livre: o próximo quadro não espera o reset
+}
+
+void ws2812_init(ws2812_t *ws, PIO pio, uint sm, uint pin, uint8_t num_leds) {
+    ws->pio = pio;
+    ws->sm = sm;
+    ws->num_leds = num_leds < WS2812_MAX_LEDS ? num_leds : WS2812_MAX_LEDS;
+    ws->busy = false;
+    ws->pending = false;
+    ws->frames_sent = 0;
+    ws->frames_skipped = 0;
+
+    uint offset = pio_add_program(pio, &ws2812_program);
+    ws2812_program_init(pio, sm, offset, pin, 800000, false);
+
+    ws->dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(ws->dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm, true));
+    dma_channel_configure(ws->dma_chan, &cfg, &pio->txf[sm], ws->tx, ws->num_leds, false);
+
+    // Os LEDs começam apagados e o primeiro quadro é sempre enviado
+    memset(ws->frame, 0, sizeof(ws->frame));
+    ws->pending = true;
+    ws2812_start(ws);
+}
+
+void ws2812_show(ws2812_t *ws, const uint32_t *grb) {
+    size_t len = ws->num_leds * sizeof(uint32_t);
+
+    // O alarme de reset pode iniciar o quadro pendente a qualquer momento
+    uint32_t status = save_and_disable_interrupts();
+
+    if (memcmp(ws->frame, grb, len) == 0) {
+        ws->frames_skipped++;
+    } else {
+        memcpy(ws->frame, grb, len);
+        ws->pending = true;
+        if (!ws->busy)
+            ws2812_start(ws);
+    }
+
+    restore_interrupts(status);
+}
@@ -0,0 +1,42 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+
+#define WS2812_MAX_LEDS 25
+#define WS2812_US_PER_LED 30 // 24 bits a 800 kHz
+#define WS2812_RESET_US 80   // Linha em nível baixo que faz os LEDs aplicarem o quadro
+
+/**
+ * Driver da matriz WS2812. O quadro é entregue à DMA, que alimenta o FIFO da máquina de estados
+ * do PIO; o fim da transmissão e o intervalo de reset são aguardados por um alarme, sem ocupar a CPU.
+ * Quadros iguais ao último pedido são descartados. Um quadro pedido durante a transmissão fica
+ * pendente (vale sempre o mais recente) e é enviado assim que o reset termina.
+ */
+typedef struct {
+    PIO pio;
+    uint sm;
+    int dma_chan;
+    uint8_t num_leds;
+    uint32_t frame[WS2812_MAX_LEDS];  // Último quadro pedido, em GRB
+    uint32_t tx[WS2812_MAX_LEDS];     // Quadro em transmissão, no formato do FIFO, lido pela DMA
+    volatile bool busy;               // Transmissão ou reset em andamento
+    volatile bool pending;            // frame ainda não foi transmitido
+    uint32_t frames_sent;
+    uint32_t frames_skipped;          // Quadros iguais ao anterior
+} ws2812_t;
+
+// Carrega o programa no PIO, configura o pino e reserva um canal de DMA
+void ws2812_init(ws2812_t *ws, PIO pio, uint sm, uint pin, uint8_t num_leds);
+
+// Pede a exibição de um quadro (num_leds cores em GRB). Não bloqueia
+void ws2812_show(ws2812_t *ws, const uint32_t *grb);
+
+// Converte valores RGB para o formato GRB dos LEDs
+static inline uint32_t ws2812_rgb(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)(g) << 16) | ((uint32_t)(r) << 8) | (uint32_t)(b);
+}
+
+#endif // WS2812_H
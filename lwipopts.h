@@ -21,6 +21,9 @@
 #define MEM_ALIGNMENT               4
 #define MEM_SIZE                    (32 * 1024)
 #define MEMP_NUM_TCP_SEG            32
+// Mais PCBs que os HTTP_MAX_CONNS estados do servidor (lib/webserver.c): quem recusa ou despeja uma
+// conexão é o pool do servidor, e não o tcp_kill_prio do lwIP, que poderia abortar um /eventos ou /ws
+#define MEMP_NUM_TCP_PCB            10
 #define MEMP_NUM_ARP_QUEUE          64
 #define PBUF_POOL_SIZE              48
 #define LWIP_ARP                    1
@@ -33,11 +36,14 @@
 #define TCP_SND_QUEUELEN            ((4 * (TCP_SND_BUF) + (TCP_MSS - 1)) / (TCP_MSS))
 #define LWIP_NETIF_STATUS_CALLBACK  1
 #define LWIP_NETIF_LINK_CALLBACK    1
+#define LWIP_NETIF_EXT_STATUS_CALLBACK 1 // Avisa o laço principal das mudanças no Wi-Fi (lib/wifi.c)
 #define LWIP_NETIF_HOSTNAME         1
 #define LWIP_NETCONN                0
-#define MEM_STATS                   0
+// Uso do heap e dos pools do lwIP, exportado em /metrics e /mem (lib/memstats.c)
+#define LWIP_STATS                  1
+#define MEM_STATS                   1
 #define SYS_STATS                   0
-#define MEMP_STATS                  0
+#define MEMP_STATS                  1
 #define LINK_STATS                  0
 // #define ETH_PAD_SIZE                2
 #define LWIP_CHKSUM_ALGORITHM       3
@@ -53,7 +59,6 @@
 
 #ifndef NDEBUG
 #define LWIP_DEBUG                  1
-#define LWIP_STATS                  1
 #define LWIP_STATS_DISPLAY          1
 #endif
 
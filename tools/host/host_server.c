@@ -0,0 +1,459 @@
+/**
+ * Servidor web da estação rodando no Linux, para medir carga com tools/loadgen.c.
+ *
+ * Compila lib/webserver.c e os módulos de que ele depende sem alterações, trocando o SDK e o lwIP
+ * pelos cabeçalhos de tools/host/include. Este arquivo implementa a API raw de TCP do lwIP sobre
+ * sockets não bloqueantes num laço poll(), com as restrições que importam no Pico W: uma única
+ * thread para todos os callbacks, fila de envio de TCP_SND_BUF bytes por conexão e no máximo
+ * MEMP_NUM_TCP_PCB conexões. O laço também publica uma amostra a cada intervalo, como o laço
+ * principal do firmware, e mede o quanto essa publicação atrasa enquanto o servidor está ocupado.
+ *
+ * Uso: host_server [-p porta] [-c conexoes] [-i intervalo_ms] [-H horas]
+ * -H preenche o histórico de longo prazo (/export) com as horas anteriores, em amostras sintéticas.
+ * Ctrl+C encerra e mostra o resumo. O mesmo resumo é servido em /mem.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#undef TCP_MSS // Vale o do lwipopts.h
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "lwip/tcp.h"
+
+#include "config.h"
+#include "history.h"
+#include "memstats.h"
+#include "rules.h"
+#include "webserver.h"
+
+#define HOST_MAX_PCBS 64     // Limite de -c
+#define HOST_RX_SIZE TCP_MSS // Bytes lidos por recv(), como um segmento
+#define HOST_SLOW_MS 500     // Unidade do intervalo do tcp_poll (TCP_SLOW_INTERVAL)
+
+struct tcp_pcb {
+    int fd;             // -1 quando a posição está livre
+    bool listening;
+    bool closing;       // tcp_close chamado: envia o que falta e fecha
+    bool fin;           // O cliente fechou o lado dele
+    void *arg;
+    tcp_accept_fn accept;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_err_fn err;
+    tcp_poll_fn poll;
+    u8_t poll_interval;
+    uint32_t next_poll_ms;
+    u16_t snd_len;      // Bytes na fila, ainda não entregues ao kernel
+    u16_t unacked;      // Entregues ao kernel; viram tcp_sent na próxima volta do laço
+    uint8_t snd[TCP_SND_BUF];
+};
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+config_store_t config;
+rules_t regras;
+
+static const config_t config_padrao = {
+    .limits = {
+        [CONFIG_TEMP]  = { 20.0f, 35.0f },
+        [CONFIG_HUM]   = { 70.0f, 90.0f },
+        [CONFIG_PRESS] = { 80.0f, 110.0f },
+    },
+};
+
+static struct tcp_pcb escuta = { .fd = -1 };
+static struct tcp_pcb pcbs[HOST_MAX_PCBS];
+static int max_pcbs = MEMP_NUM_TCP_PCB;
+static u16_t porta = 8080;
+static volatile sig_atomic_t rodando = 1;
+
+// Medidas do resumo
+static uint64_t inicio_us;
+static uint32_t pcbs_usados, pcbs_pico;
+static uint32_t fila_bytes, fila_pico;     // Soma de snd_len + unacked de todas as conexões
+static uint32_t pbuf_bytes, pbuf_pico;     // Dados recebidos ainda não liberados com pbuf_free
+static uint32_t conexoes, recusadas;       // recusadas: sem pcb livre, como o pool do lwIP esgotado
+static uint64_t callbacks, callback_us, callback_max_us;
+static uint32_t amostras, atraso_max_us;
+static uint64_t atraso_total_us;
+
+// ======== FLASH ===========
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    memset(host_flash + flash_offs, 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+}
+
+// ======== PBUF ===========
+
+u8_t pbuf_free(struct pbuf *p) {
+    pbuf_bytes -= p->tot_len;
+    free(p);
+    return 1;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset) {
+    if (offset >= p->tot_len) return 0;
+    if (len > p->tot_len - offset) len = p->tot_len - offset;
+    memcpy(dataptr, (const uint8_t *)p->payload + offset, len);
+    return len;
+}
+
+// ======== TCP ===========
+
+static uint32_t agora_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static void fila_mudou(int delta) {
+    fila_bytes += delta;
+    if (fila_bytes > fila_pico) fila_pico = fila_bytes;
+}
+
+static void pcb_free(struct tcp_pcb *pcb) {
+    fila_mudou(-(int)(pcb->snd_len + pcb->unacked));
+    close(pcb->fd);
+    memset(pcb, 0, sizeof(*pcb));
+    pcb->fd = -1;
+    pcbs_usados--;
+}
+
+// Os tempos dos callbacks somam o que, no Pico W, o lwIP roubaria do laço principal
+#define CALLBACK(expr) do {                                   \
+        uint64_t t0_ = time_us_64();                          \
+        expr;                                                 \
+        uint64_t dt_ = time_us_64() - t0_;                    \
+        callbacks++;                                          \
+        callback_us += dt_;                                   \
+        if (dt_ > callback_max_us) callback_max_us = dt_;     \
+    } while (0)
+
+struct tcp_pcb *tcp_new(void) {
+    return escuta.fd < 0 && !escuta.listening ? &escuta : NULL;
+}
+
+err_t tcp_bind(struct tcp_pcb *pcb, const ip_addr_t *ipaddr, u16_t port) {
+    (void)ipaddr;
+    (void)port; // A porta 80 do firmware vira a porta de -p
+    pcb->fd = socket(AF_INET, SOCK_STREAM, 0);
+    int um = 1;
+    setsockopt(pcb->fd, SOL_SOCKET, SO_REUSEADDR, &um, sizeof(um));
+
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(porta), .sin_addr.s_addr = htonl(INADDR_ANY) };
+    if (bind(pcb->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        exit(1);
+    }
+    return ERR_OK;
+}
+
+struct tcp_pcb *tcp_listen(struct tcp_pcb *pcb) {
+    listen(pcb->fd, 64);
+    fcntl(pcb->fd, F_SETFL, O_NONBLOCK);
+    pcb->listening = true;
+    return pcb;
+}
+
+void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn accept) { pcb->accept = accept; }
+void tcp_arg(struct tcp_pcb *pcb, void *arg) { pcb->arg = arg; }
+void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn recv) { pcb->recv = recv; }
+void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn sent) { pcb->sent = sent; }
+void tcp_err(struct tcp_pcb *pcb, tcp_err_fn err) { pcb->err = err; }
+
+void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn poll, u8_t interval) {
+    pcb->poll = poll;
+    pcb->poll_interval = interval;
+    pcb->next_poll_ms = agora_ms() + interval * HOST_SLOW_MS;
+}
+
+u16_t tcp_sndbuf(const struct tcp_pcb *pcb) {
+    return TCP_SND_BUF - pcb->snd_len - pcb->unacked;
+}
+
+// Sempre copia: sem TCP_WRITE_FLAG_COPY o lwIP referencia os dados, o que não muda o que o servidor vê
+err_t tcp_write(struct tcp_pcb *pcb, const void *dataptr, u16_t len, u8_t apiflags) {
+    (void)apiflags;
+    if (pcb->closing) return ERR_CLSD;
+    if (len > tcp_sndbuf(pcb)) return ERR_MEM;
+    memcpy(pcb->snd + pcb->snd_len, dataptr, len);
+    pcb->snd_len += len;
+    fila_mudou(len);
+    return ERR_OK;
+}
+
+err_t tcp_output(struct tcp_pcb *pcb) {
+    if (!pcb->snd_len) return ERR_OK;
+    ssize_t n = send(pcb->fd, pcb->snd, pcb->snd_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+        memmove(pcb->snd, pcb->snd + n, pcb->snd_len - n);
+        pcb->snd_len -= n;
+        pcb->unacked += n;
+    }
+    return ERR_OK;
+}
+
+void tcp_recved(struct tcp_pcb *pcb, u16_t len) {
+    (void)pcb;
+    (void)len; // A janela fica a cargo do kernel
+}
+
+void tcp_nagle_disable(struct tcp_pcb *pcb) {
+    int um = 1;
+    setsockopt(pcb->fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+}
+
+// Como no lwIP, o pcb continua existindo até a fila de envio esvaziar, mas sem callbacks
+err_t tcp_close(struct tcp_pcb *pcb) {
+    pcb->closing = true;
+    pcb->recv = NULL;
+    pcb->sent = NULL;
+    pcb->err = NULL;
+    pcb->poll = NULL;
+    return ERR_OK;
+}
+
+// Envia RST e avisa o tcp_err com ERR_ABRT, como o lwIP
+void tcp_abort(struct tcp_pcb *pcb) {
+    struct linger l = { 1, 0 };
+    setsockopt(pcb->fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    tcp_err_fn err = pcb->err;
+    void *arg = pcb->arg;
+    pcb_free(pcb);
+    if (err) err(arg, ERR_ABRT);
+}
+
+// ======== LAÇO ===========
+
+static void aceitar(void) {
+    int fd;
+    while ((fd = accept(escuta.fd, NULL, NULL)) >= 0) {
+        conexoes++;
+        struct tcp_pcb *pcb = NULL;
+        for (int i = 0; i < max_pcbs && !pcb; i++) {
+            if (pcbs[i].fd < 0) pcb = &pcbs[i];
+        }
+        if (!pcb) {
+            struct linger l = { 1, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+            close(fd);
+            recusadas++;
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        pcb->fd = fd;
+        pcb->arg = escuta.arg;
+        if (++pcbs_usados > pcbs_pico) pcbs_pico = pcbs_usados;
+        CALLBACK(escuta.accept(escuta.arg, pcb, ERR_OK));
+    }
+}
+
+static void receber(struct tcp_pcb *pcb) {
+    struct pbuf *p = malloc(sizeof(struct pbuf) + HOST_RX_SIZE);
+    p->next = NULL;
+    p->payload = p + 1;
+    ssize_t n = recv(pcb->fd, p->payload, HOST_RX_SIZE, 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        free(p);
+        return;
+    }
+
+    if (n < 0) { // Conexão resetada pelo cliente
+        free(p);
+        tcp_err_fn err = pcb->err;
+        void *arg = pcb->arg;
+        pcb_free(pcb);
+        if (err) CALLBACK(err(arg, ERR_RST));
+        return;
+    }
+
+    if (n == 0) {
+        free(p);
+        pcb->fin = true;
+        if (pcb->recv) {
+            CALLBACK(pcb->recv(pcb->arg, pcb, NULL, ERR_OK));
+        } else {
+            tcp_close(pcb);
+        }
+        return;
+    }
+
+    p->len = p->tot_len = n;
+    pbuf_bytes += n;
+    if (pbuf_bytes > pbuf_pico) pbuf_pico = pbuf_bytes;
+    if (pcb->recv) {
+        CALLBACK(pcb->recv(pcb->arg, pcb, p, ERR_OK));
+    } else {
+        pbuf_free(p);
+    }
+}
+
+// Dados aceitos pelo kernel contam como confirmados; tcp_sent é chamado fora de tcp_output, como no lwIP
+static void confirmar(struct tcp_pcb *pcb) {
+    tcp_output(pcb);
+    if (!pcb->unacked) return;
+
+    u16_t n = pcb->unacked;
+    pcb->unacked = 0;
+    fila_mudou(-(int)n);
+    if (pcb->sent) CALLBACK(pcb->sent(pcb->arg, pcb, n));
+}
+
+// Uma amostra sintética, no ritmo do laço principal do firmware
+static void publicar(uint32_t seq) {
+    float t = 25.0f + 5.0f * sinf(seq * 0.1f);
+    float h = 80.0f + 5.0f * cosf(seq * 0.07f);
+    float p = 101.3f + 0.5f * sinf(seq * 0.03f);
+    CALLBACK(webserver_publish_sample(seq, t, h, p));
+}
+
+// Histórico das horas anteriores, uma amostra a cada intervalo, como se o servidor já rodasse há tanto tempo
+static void preencher(uint32_t horas, uint32_t intervalo_ms) {
+    uint32_t agora_ms = to_ms_since_boot(get_absolute_time());
+    uint32_t duracao_ms = horas * 3600000u > agora_ms ? agora_ms : horas * 3600000u;
+    uint32_t n = 0;
+    for (uint32_t t = agora_ms - duracao_ms; t < agora_ms; t += intervalo_ms, n++) {
+        history_add(t, 20.0f + 8.0f * sinf(t / 13750000.0f), 70.0f + 15.0f * cosf(t / 13750000.0f),
+                    101.3f + 0.8f * sinf(t / 86400000.0f));
+    }
+    printf("Historico: %lu amostras em %lu h\n", (unsigned long)n, (unsigned long)(duracao_ms / 3600000u));
+}
+
+size_t memstats_format(char *buf, size_t size) {
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    uint64_t tempo_us = time_us_64() - inicio_us;
+
+    return snprintf(buf, size,
+                    "conexoes: %lu aceitas, %lu recusadas, %lu em uso (pico %lu) de %d\n"
+                    "fila de envio: %lu bytes (pico %lu), limite de %d por conexao\n"
+                    "pbufs: %lu bytes (pico %lu)\n"
+                    "callbacks: %llu, %.1f%% do tempo, maior %llu us\n"
+                    "amostras: %lu, atraso medio %llu us, maior %lu us\n"
+                    "rss maximo: %ld KiB\n",
+                    (unsigned long)conexoes, (unsigned long)recusadas, (unsigned long)pcbs_usados,
+                    (unsigned long)pcbs_pico, max_pcbs,
+                    (unsigned long)fila_bytes, (unsigned long)fila_pico, TCP_SND_BUF,
+                    (unsigned long)pbuf_bytes, (unsigned long)pbuf_pico,
+                    (unsigned long long)callbacks, tempo_us ? 100.0 * callback_us / tempo_us : 0.0,
+                    (unsigned long long)callback_max_us,
+                    (unsigned long)amostras, (unsigned long long)(amostras ? atraso_total_us / amostras : 0),
+                    (unsigned long)atraso_max_us, uso.ru_maxrss);
+}
+
+static void parar(int sig) {
+    (void)sig;
+    rodando = 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t intervalo_ms = 500, horas = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:c:i:H:")) != -1) {
+        switch (opt) {
+            case 'p': porta = atoi(optarg); break;
+            case 'c': max_pcbs = atoi(optarg); break;
+            case 'i': intervalo_ms = atoi(optarg); break;
+            case 'H': horas = atoi(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-p porta] [-c conexoes] [-i intervalo_ms] [-H horas]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (max_pcbs < 1 || max_pcbs > HOST_MAX_PCBS) max_pcbs = HOST_MAX_PCBS;
+
+    for (int i = 0; i < HOST_MAX_PCBS; i++) pcbs[i].fd = -1;
+    memset(host_flash, 0xFF, sizeof(host_flash));
+    signal(SIGINT, parar);
+    signal(SIGTERM, parar);
+    inicio_us = time_us_64();
+
+    config_init(&config, &config_padrao);
+    rules_init(&regras);
+    if (!webserver_init()) return 1;
+    if (horas) preencher(horas, intervalo_ms);
+    printf("Escutando na porta %u, %d conexoes, amostra a cada %lu ms\n", porta, max_pcbs, (unsigned long)intervalo_ms);
+
+    uint32_t seq = 0;
+    uint64_t proxima_amostra = time_us_64() + intervalo_ms * 1000ull;
+    while (rodando) {
+        struct pollfd fds[HOST_MAX_PCBS + 1];
+        struct tcp_pcb *donos[HOST_MAX_PCBS + 1];
+        int nfds = 0;
+        bool confirmar_ja = false;
+
+        fds[nfds] = (struct pollfd){ .fd = escuta.fd, .events = POLLIN };
+        donos[nfds++] = &escuta;
+        for (int i = 0; i < max_pcbs; i++) {
+            struct tcp_pcb *pcb = &pcbs[i];
+            if (pcb->fd < 0) continue;
+            short ev = 0;
+            if (!pcb->fin && !pcb->closing) ev |= POLLIN;
+            if (pcb->snd_len) ev |= POLLOUT;
+            if (pcb->unacked) confirmar_ja = true;
+            fds[nfds] = (struct pollfd){ .fd = pcb->fd, .events = ev };
+            donos[nfds++] = pcb;
+        }
+
+        // Dados entregues ao kernel ainda sem tcp_sent: o envio continua sem esperar pelo poll()
+        uint64_t agora = time_us_64();
+        int espera = agora >= proxima_amostra ? 0 : (int)((proxima_amostra - agora) / 1000) + 1;
+        if (espera > HOST_SLOW_MS) espera = HOST_SLOW_MS;
+        if (confirmar_ja) espera = 0;
+        if (poll(fds, nfds, espera) < 0 && errno != EINTR) break;
+
+        if (fds[0].revents & POLLIN) aceitar();
+        for (int i = 1; i < nfds; i++) {
+            struct tcp_pcb *pcb = donos[i];
+            if (pcb->fd != fds[i].fd) continue; // Liberado por um callback anterior
+            if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) receber(pcb);
+        }
+
+        // Confirmações, fechamentos pendentes e tcp_poll
+        uint32_t ms = agora_ms();
+        for (int i = 0; i < max_pcbs; i++) {
+            struct tcp_pcb *pcb = &pcbs[i];
+            if (pcb->fd < 0) continue;
+            confirmar(pcb);
+            if (pcb->fd < 0) continue;
+            if (pcb->closing && !pcb->snd_len) {
+                pcb_free(pcb);
+                continue;
+            }
+            if (pcb->poll && (int32_t)(ms - pcb->next_poll_ms) >= 0) {
+                pcb->next_poll_ms = ms + pcb->poll_interval * HOST_SLOW_MS;
+                CALLBACK(pcb->poll(pcb->arg, pcb));
+            }
+        }
+
+        agora = time_us_64();
+        if (agora >= proxima_amostra) {
+            uint32_t atraso = agora - proxima_amostra;
+            atraso_total_us += atraso;
+            if (atraso > atraso_max_us) atraso_max_us = atraso;
+            amostras++;
+            publicar(++seq);
+            proxima_amostra += intervalo_ms * 1000ull;
+        }
+    }
+
+    static char resumo[MEMSTATS_TEXT_MAX];
+    memstats_format(resumo, sizeof(resumo));
+    fputs(resumo, stdout);
+    return 0;
+}
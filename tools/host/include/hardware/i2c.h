@@ -0,0 +1,36 @@
+#ifndef HOST_HARDWARE_I2C_H
+#define HOST_HARDWARE_I2C_H
+
+// I2C no host: as transações dos sensores vêm de uma gravação (tools/replay.c) e o display não
+// transmite de verdade (tools/oled_bench.c)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define _u(x) x##u
+
+typedef struct i2c_inst i2c_inst_t;
+
+// Registradores usados pelo envio do display por DMA (lib/ssd1306.c)
+typedef struct {
+    volatile uint32_t enable;
+    volatile uint32_t tar;
+    volatile uint32_t status;
+    volatile uint32_t raw_intr_stat;
+    volatile uint32_t clr_tx_abrt;
+    volatile uint32_t data_cmd;
+} i2c_hw_t;
+
+#define I2C_IC_STATUS_TFE_BITS            _u(0x00000004)
+#define I2C_IC_STATUS_MST_ACTIVITY_BITS   _u(0x00000020)
+#define I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS _u(0x00000040)
+#define I2C_IC_DATA_CMD_STOP_BITS         _u(0x00000200)
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+unsigned int i2c_get_dreq(i2c_inst_t *i2c, bool is_tx);
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+#endif // HOST_HARDWARE_I2C_H
@@ -0,0 +1,11 @@
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+// No host não há Wi-Fi (lib/wifi.c fica fora) e o lwIP roda numa única thread
+
+#include "pico/stdlib.h"
+
+static inline void cyw43_arch_lwip_begin(void) {}
+static inline void cyw43_arch_lwip_end(void) {}
+
+#endif // HOST_PICO_CYW43_ARCH_H
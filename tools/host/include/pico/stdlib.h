@@ -0,0 +1,46 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Subconjunto do pico/stdlib.h usado pelas ferramentas do host (servidor web e replay), sobre o relógio do Linux
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+
+// A flash é um vetor em RAM (host_server.c); XIP_BASE aponta para ele
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t; // Só o tipo, usado em alarm.h: o host não tem alarmes de hardware
+
+static inline uint64_t time_us_64(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+static inline absolute_time_t get_absolute_time(void) {
+    return time_us_64();
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+static inline void tight_loop_contents(void) {}
+
+// Definida por quem usa: tools/replay.c só avança o relógio da gravação
+void sleep_ms(uint32_t ms);
+
+#endif // HOST_PICO_STDLIB_H
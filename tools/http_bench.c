@@ -0,0 +1,88 @@
+/**
+ * Vazão do parser HTTP (lib/http_parser.c) no computador.
+ *
+ * Analisa repetidamente uma requisição típica de um navegador (WebSocket, ETag, gzip e
+ * Last-Event-ID) entregue de uma vez e em pedaços pequenos, como segmentos TCP curtos, e mostra
+ * MB/s e requisições por segundo de cada caso. Antes de medir confere o resultado de cada divisão
+ * de 1 a 300 bytes, para a medição não valer para um parser errado.
+ *
+ * Uso: http_bench [-n requisicoes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "http_parser.h"
+
+static const char requisicao[] =
+    "GET /estado?since=42&tipo=temp&x=a%20b+c HTTP/1.1\r\nHost: estacao.local\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+    "Accept-Language: pt-BR,pt;q=0.8,en-US;q=0.5,en;q=0.3\r\nConnection: keep-alive, Upgrade\r\n"
+    "Upgrade: websocket\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nIf-None-Match: W/\"abc123\"\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\nLast-Event-ID: 77\r\n\r\n";
+
+static double agora_s(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void analisar(http_parser_t *p, size_t pedaco) {
+    size_t len = sizeof(requisicao) - 1, off = 0;
+    http_parser_init(p);
+    while (off < len && !http_parser_done(p) && !http_parser_failed(p)) {
+        size_t n = len - off < pedaco ? len - off : pedaco;
+        off += http_parser_feed(p, requisicao + off, n);
+    }
+}
+
+static int conferir(size_t pedaco) {
+    http_parser_t p;
+    char valor[32];
+    uint32_t since;
+    analisar(&p, pedaco);
+    if (!http_parser_done(&p) || p.method != HTTP_METHOD_GET || !http_path_is(&p, "/estado")) return 0;
+    if (!http_query_get_u32(&p, "since", &since) || since != 42) return 0;
+    if (!http_query_get(&p, "x", valor, sizeof(valor)) || strcmp(valor, "a b c") != 0) return 0;
+    const uint8_t flags = HTTP_FLAG_HTTP11 | HTTP_FLAG_CONN_KEEPALIVE | HTTP_FLAG_CONN_UPGRADE |
+                          HTTP_FLAG_UPGRADE_WS | HTTP_FLAG_ACCEPT_GZIP | HTTP_FLAG_LAST_EVENT_ID;
+    if ((p.flags & flags) != flags || p.last_event_id != 77) return 0;
+    return strcmp(p.ws_key, "dGhlIHNhbXBsZSBub25jZQ==") == 0 && strcmp(p.etag, "abc123") == 0;
+}
+
+int main(int argc, char **argv) {
+    long requisicoes = 1000000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': requisicoes = atol(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-n requisicoes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (requisicoes < 1) requisicoes = 1;
+
+    for (size_t pedaco = 1; pedaco <= 300; pedaco++) {
+        if (!conferir(pedaco)) {
+            fprintf(stderr, "resultado errado com pedacos de %zu bytes\n", pedaco);
+            return 1;
+        }
+    }
+
+    static const size_t pedacos[] = { sizeof(requisicao), 64, 8 };
+    size_t len = sizeof(requisicao) - 1;
+    for (size_t i = 0; i < sizeof(pedacos) / sizeof(pedacos[0]); i++) {
+        http_parser_t p;
+        double t0 = agora_s();
+        for (long r = 0; r < requisicoes; r++) analisar(&p, pedacos[i]);
+        double s = agora_s() - t0;
+        if (pedacos[i] >= len) printf("inteira:        ");
+        else printf("pedacos de %3zu: ", pedacos[i]);
+        printf("%7.1f MB/s %9.0f req/s (%zu bytes)\n", len * requisicoes / s / 1e6, requisicoes / s, len);
+    }
+    return 0;
+}
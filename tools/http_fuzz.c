@@ -0,0 +1,131 @@
+/**
+ * Fuzzing do parser HTTP (lib/http_parser.c).
+ *
+ * LLVMFuzzerTestOneInput() entrega a entrada ao parser em pedaços de tamanho sorteado a partir do
+ * primeiro byte, como chegam pelo TCP, e confere os invariantes que o servidor assume: nunca
+ * consumir mais que o oferecido, campos sempre terminados em '\0' dentro dos limites e consultas
+ * à query seguras em qualquer estado. O que sobra depois de uma requisição completa vai para um
+ * parser novo, como numa conexão keep-alive. Qualquer violação chama abort().
+ *
+ * Com clang (make http_fuzz_libfuzzer) o alvo roda sob o libFuzzer com ASan. Sem ele, o main()
+ * abaixo gera entradas aleatórias misturando trechos de uma requisição real, ou repete os
+ * arquivos passados na linha de comando (casos salvos pelo libFuzzer).
+ *
+ * Uso: http_fuzz [-n iteracoes] [-s semente] [arquivo...]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_parser.h"
+
+#define ENTRADA_MAX 1024
+
+#define CONFERIR(cond) do { if (!(cond)) { \
+    fprintf(stderr, "%s:%d: falhou %s\n", __FILE__, __LINE__, #cond); abort(); } } while (0)
+
+static void conferir_campos(const http_parser_t *p) {
+    CONFERIR(p->target_len < HTTP_TARGET_MAX);
+    CONFERIR(memchr(p->target, '\0', HTTP_TARGET_MAX) != NULL);
+    CONFERIR(memchr(p->etag, '\0', HTTP_ETAG_MAX) != NULL);
+    CONFERIR(memchr(p->ws_key, '\0', HTTP_WS_KEY_MAX) != NULL);
+    CONFERIR(p->path_len <= p->target_len);
+    if (http_parser_failed(p)) CONFERIR(p->error >= 400 && p->error < 600);
+
+    char valor[16];
+    float f;
+    uint32_t u;
+    http_query_get(p, "since", valor, sizeof(valor));
+    http_query_get(p, "", valor, sizeof(valor));
+    http_query_get(p, "x", valor, 1);
+    http_query_get_float(p, "temp_max", &f);
+    http_query_get_u32(p, "since", &u);
+    http_path_is(p, "/estado");
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size == 0) return 0;
+    size_t pedaco = 1 + data[0] % 64;
+    const char *bytes = (const char *)data + 1;
+    size_t len = size - 1;
+    size_t off = 0;
+
+    // Requisições em sequência na mesma "conexão" enquanto o parser completa cada uma
+    while (off < len) {
+        http_parser_t p;
+        http_parser_init(&p);
+        while (off < len && !http_parser_done(&p) && !http_parser_failed(&p)) {
+            size_t n = len - off < pedaco ? len - off : pedaco;
+            size_t usados = http_parser_feed(&p, bytes + off, n);
+            CONFERIR(usados <= n);
+            off += usados;
+            if (usados < n) CONFERIR(http_parser_done(&p) || http_parser_failed(&p));
+            conferir_campos(&p);
+        }
+        if (!http_parser_done(&p)) break;
+    }
+    return 0;
+}
+
+#ifndef HTTP_FUZZ_LIBFUZZER
+#include <unistd.h>
+
+static const char requisicao[] =
+    "GET /estado?since=42&tipo=temp&x=a%20b+c HTTP/1.1\r\nHost: x\r\nConnection: keep-alive, Upgrade\r\n"
+    "Upgrade: websocket\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nIf-None-Match: W/\"abc123\"\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\nLast-Event-ID: 77\r\nContent-Length: 3\r\n\r\nabc";
+
+static int repetir_arquivo(const char *nome) {
+    static uint8_t dados[1 << 20];
+    FILE *f = fopen(nome, "rb");
+    if (!f) {
+        perror(nome);
+        return 1;
+    }
+    size_t n = fread(dados, 1, sizeof(dados), f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(dados, n);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    long iteracoes = 1000000;
+    unsigned semente = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': iteracoes = atol(optarg); break;
+            case 's': semente = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "uso: %s [-n iteracoes] [-s semente] [arquivo...]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind < argc) {
+        int erros = 0;
+        for (int i = optind; i < argc; i++) erros += repetir_arquivo(argv[i]);
+        return erros != 0;
+    }
+
+    srand(semente);
+    uint8_t entrada[ENTRADA_MAX];
+    size_t tam_req = sizeof(requisicao) - 1;
+    for (long it = 0; it < iteracoes; it++) {
+        size_t n = rand() % sizeof(entrada);
+        for (size_t i = 0; i < n; i++) {
+            int k = rand() % 10;
+            entrada[i] = k < 3 ? requisicao[rand() % tam_req] : k < 5 ? "\r\n :?&=%"[rand() % 8] : rand();
+        }
+        // Metade das entradas começa com um prefixo válido, para o parser chegar aos cabeçalhos e ao corpo
+        if (n > 1 && rand() % 2) {
+            size_t prefixo = 1 + rand() % tam_req;
+            if (prefixo > n - 1) prefixo = n - 1;
+            memcpy(entrada + 1, requisicao, prefixo);
+        }
+        LLVMFuzzerTestOneInput(entrada, n);
+    }
+    printf("http_fuzz: %ld entradas sem falhas\n", iteracoes);
+    return 0;
+}
+#endif
@@ -0,0 +1,562 @@
+/**
+ * Gerador de carga HTTP para o servidor web da estação (no Pico W ou em tools/host/host_server.c).
+ *
+ * Abre N clientes simultâneos, cada um repetindo uma mistura sorteada de requisições de um painel:
+ * a página (/), o histórico (/estado?since=...) e a alteração de limites (/limites?...). Ao final
+ * mostra requisições por segundo, latência p50/p99 por rota, falhas e o relatório de memória do
+ * servidor (/mem), para comparar alterações no servidor de forma objetiva.
+ *
+ * Com -W, cada cliente abre um WebSocket em /ws e só recebe os quadros de amostra; o relatório
+ * passa a ser quadros por segundo, bytes por quadro, intervalo entre quadros e amostras perdidas.
+ * Nesse modo o timeout vale para o intervalo entre quadros e deve ser maior que o das amostras.
+ *
+ * Uso: loadgen [-h host] [-p porta] [-c clientes] [-d segundos] [-m pagina:estado:limites]
+ *              [-w espera_ms] [-k 0|1] [-t timeout_ms] [-W]
+ */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_CLIENTES 256
+#define CABECALHO_MAX 2048 // Cabeçalho de resposta; maior que isso é falha
+#define CORPO_INICIO 256   // Início do corpo guardado, para ler o "seq" de /estado
+#define REPETIR_MS 1000    // Espera depois de uma falha, como a retransmissão do SYN de um navegador
+
+enum rota {
+    ROTA_PAGINA,
+    ROTA_ESTADO,
+    ROTA_LIMITES,
+    NUM_ROTAS
+};
+
+static const char *const nomes_rotas[NUM_ROTAS] = { "/", "/estado", "/limites" };
+
+enum fase {
+    FASE_ESPERA,    // Aguardando o momento da próxima requisição
+    FASE_CONECTANDO,
+    FASE_ENVIANDO,
+    FASE_CABECALHO,
+    FASE_CORPO,
+    FASE_WS         // WebSocket aberto, recebendo quadros
+};
+
+enum falha {
+    FALHA_CONEXAO,  // connect recusado ou resetado antes da resposta
+    FALHA_FECHADA,  // Conexão fechada no meio da resposta
+    FALHA_TIMEOUT,
+    FALHA_STATUS,   // Resposta diferente de 2xx/304
+    NUM_FALHAS
+};
+
+static const char *const nomes_falhas[NUM_FALHAS] = { "conexao", "fechada", "timeout", "status" };
+
+struct cliente {
+    int fd;                 // -1 sem conexão
+    enum fase fase;
+    enum rota rota;
+    uint64_t inicio_us;     // Início da requisição atual, incluindo a conexão se foi preciso abrir uma
+    uint64_t proxima_us;    // FASE_ESPERA: quando enviar a próxima requisição
+    char req[256];
+    int req_len, enviado;
+    char cab[CABECALHO_MAX];
+    int cab_len;
+    char corpo[CORPO_INICIO];   // No WebSocket, o quadro ainda incompleto
+    int corpo_len;
+    long restante;          // Bytes do corpo que faltam; -1 até o fechamento da conexão
+    bool chunked;
+    char fim[5];            // Últimos bytes do corpo chunked, para achar o "0\r\n\r\n"
+    bool fechar;            // Servidor pediu Connection: close
+    uint32_t seq;           // Última amostra recebida em /estado ou pelo WebSocket
+    uint64_t quadro_us;     // FASE_WS: chegada do último quadro
+};
+
+// Latências de uma rota, em microssegundos
+struct amostras {
+    uint32_t *us;
+    size_t n, cap;
+};
+
+static struct sockaddr_in destino;
+static const char *host = "127.0.0.1";
+static int porta = 8080;
+static int num_clientes = 8;
+static int duracao_s = 10;
+static int pesos[NUM_ROTAS] = { 1, 18, 1 };
+static int espera_ms = 0;
+static bool keep_alive = true;
+static int timeout_ms = 2000;
+static bool modo_ws = false;
+
+static struct cliente clientes[MAX_CLIENTES];
+static struct amostras latencias[NUM_ROTAS];
+static uint32_t falhas[NUM_FALHAS];
+static uint32_t status_falhas[6];   // Respostas em falha por classe (1xx a 5xx)
+static uint32_t conexoes_abertas;
+
+// Modo WebSocket
+static struct amostras handshakes;   // Latência até o 101
+static struct amostras intervalos;   // Entre quadros de amostra consecutivos de um cliente
+static uint64_t quadros_ws, bytes_ws; // Quadros de amostra recebidos e seus bytes, com cabeçalho
+static uint64_t amostras_perdidas;    // Saltos no número de sequência, inclusive durante reconexões
+
+static uint64_t agora_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void acrescentar(struct amostras *a, uint32_t us) {
+    if (a->n == a->cap) {
+        a->cap = a->cap ? 2 * a->cap : 4096;
+        a->us = realloc(a->us, a->cap * sizeof(uint32_t));
+    }
+    a->us[a->n++] = us;
+}
+
+static void registrar(enum rota rota, uint32_t us) {
+    acrescentar(&latencias[rota], us);
+}
+
+static int comparar(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentil(const struct amostras *a, double p) {
+    if (!a->n) return 0;
+    size_t i = (size_t)(p * (a->n - 1) + 0.5);
+    return a->us[i];
+}
+
+static enum rota sortear_rota(void) {
+    int total = pesos[ROTA_PAGINA] + pesos[ROTA_ESTADO] + pesos[ROTA_LIMITES];
+    int r = rand() % total;
+    for (int i = 0; i < NUM_ROTAS; i++) {
+        if (r < pesos[i]) return (enum rota)i;
+        r -= pesos[i];
+    }
+    return ROTA_ESTADO;
+}
+
+static void fechar(struct cliente *c) {
+    if (c->fd >= 0) close(c->fd);
+    c->fd = -1;
+}
+
+static void agendar(struct cliente *c, uint64_t agora) {
+    c->fase = FASE_ESPERA;
+    c->proxima_us = agora + espera_ms * 1000ull;
+}
+
+static void falhar(struct cliente *c, enum falha f, uint64_t agora) {
+    falhas[f]++;
+    fechar(c);
+    agendar(c, agora);
+    if (espera_ms < REPETIR_MS) c->proxima_us = agora + REPETIR_MS * 1000ull;
+}
+
+// Monta a próxima requisição e abre a conexão se for preciso
+static void iniciar(struct cliente *c, uint64_t agora) {
+    c->rota = sortear_rota();
+    const char *conexao = keep_alive ? "keep-alive" : "close";
+    switch (modo_ws ? NUM_ROTAS : c->rota) {
+        case NUM_ROTAS:
+            c->req_len = snprintf(c->req, sizeof(c->req),
+                                  "GET /ws HTTP/1.1\r\nHost: %s\r\nConnection: Upgrade\r\nUpgrade: websocket\r\n"
+                                  "Sec-WebSocket-Version: 13\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n", host);
+            break;
+        case ROTA_PAGINA:
+            c->req_len = snprintf(c->req, sizeof(c->req), "GET / HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n", host, conexao);
+            break;
+        case ROTA_ESTADO:
+            c->req_len = snprintf(c->req, sizeof(c->req), "GET /estado?since=%lu HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n",
+                                  (unsigned long)c->seq, host, conexao);
+            break;
+        default: {
+            // Alterna entre dois conjuntos válidos, como um usuário ajustando a faixa de temperatura
+            int max = (rand() & 1) ? 35 : 36;
+            c->req_len = snprintf(c->req, sizeof(c->req),
+                                  "GET /limites?temp_min=20&temp_max=%d&hum_min=70&hum_max=90&press_min=80&press_max=110 HTTP/1.1\r\n"
+                                  "Host: %s\r\nConnection: %s\r\n\r\n", max, host, conexao);
+            break;
+        }
+    }
+    c->enviado = 0;
+    c->cab_len = 0;
+    c->corpo_len = 0;
+    c->chunked = false;
+    c->fechar = false;
+    c->restante = -1;
+    memset(c->fim, 0, sizeof(c->fim));
+    c->inicio_us = agora;
+
+    if (c->fd >= 0) {
+        c->fase = FASE_ENVIANDO;
+        return;
+    }
+
+    c->fd = socket(AF_INET, SOCK_STREAM, 0);
+    fcntl(c->fd, F_SETFL, O_NONBLOCK);
+    int um = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &um, sizeof(um));
+    conexoes_abertas++;
+    if (connect(c->fd, (struct sockaddr *)&destino, sizeof(destino)) < 0 && errno != EINPROGRESS) {
+        falhar(c, FALHA_CONEXAO, agora);
+        return;
+    }
+    c->fase = FASE_CONECTANDO;
+}
+
+static void concluir(struct cliente *c, uint64_t agora) {
+    registrar(c->rota, agora - c->inicio_us);
+
+    if (c->rota == ROTA_ESTADO) {
+        c->corpo[c->corpo_len < CORPO_INICIO ? c->corpo_len : CORPO_INICIO - 1] = '\0';
+        const char *seq = strstr(c->corpo, "\"seq\":");
+        if (seq) c->seq = strtoul(seq + 6, NULL, 10);
+    }
+
+    if (c->fechar || !keep_alive) fechar(c);
+    agendar(c, agora);
+}
+
+// Interpreta o cabeçalho completo. Retorna false se a resposta é uma falha
+static bool ler_cabecalho(struct cliente *c) {
+    c->cab[c->cab_len] = '\0';
+    int status = 0;
+    sscanf(c->cab, "HTTP/1.%*d %d", &status);
+    bool esperado = modo_ws ? status == 101 : (status >= 200 && status < 300) || status == 304;
+    if (!esperado) {
+        status_falhas[status >= 100 && status < 600 ? status / 100 : 0]++;
+        return false;
+    }
+
+    for (char *linha = strstr(c->cab, "\r\n"); linha; linha = strstr(linha + 2, "\r\n")) {
+        const char *h = linha + 2;
+        if (!strncasecmp(h, "Content-Length:", 15)) {
+            c->restante = strtol(h + 15, NULL, 10);
+        } else if (!strncasecmp(h, "Transfer-Encoding:", 18) && strstr(h, "chunked")) {
+            c->chunked = true;
+        } else if (!strncasecmp(h, "Connection:", 11) && strncasecmp(h + 11 + strspn(h + 11, " "), "close", 5) == 0) {
+            c->fechar = true;
+        }
+    }
+    if (status == 304) c->restante = 0;
+    return true;
+}
+
+// Consome bytes do corpo. Retorna true quando a resposta terminou
+static bool ler_corpo(struct cliente *c, const char *dados, long n) {
+    int guardar = CORPO_INICIO - 1 - c->corpo_len;
+    if (guardar > n) guardar = n;
+    if (guardar > 0) {
+        memcpy(c->corpo + c->corpo_len, dados, guardar);
+        c->corpo_len += guardar;
+    }
+
+    if (c->chunked) {
+        for (long i = 0; i < n; i++) {
+            memmove(c->fim, c->fim + 1, sizeof(c->fim) - 1);
+            c->fim[sizeof(c->fim) - 1] = dados[i];
+            if (!memcmp(c->fim, "0\r\n\r\n", 5)) return true;
+        }
+        return false;
+    }
+    if (c->restante >= 0) {
+        c->restante -= n;
+        return c->restante <= 0;
+    }
+    return false; // Sem tamanho: termina quando o servidor fechar
+}
+
+// Consome quadros do servidor no WebSocket (sem máscara). Um close do servidor encerra a conexão
+static void ler_quadros(struct cliente *c, const char *dados, long n, uint64_t agora) {
+    while (n > 0) {
+        int copiar = CORPO_INICIO - c->corpo_len;
+        if (copiar > n) copiar = n;
+        memcpy(c->corpo + c->corpo_len, dados, copiar);
+        c->corpo_len += copiar;
+        dados += copiar;
+        n -= copiar;
+
+        int pos = 0;
+        while (c->corpo_len - pos >= 2) {
+            const uint8_t *q = (const uint8_t *)c->corpo + pos;
+            int cab = 2;
+            long len = q[1] & 0x7F;
+            if (len == 126) {
+                if (c->corpo_len - pos < 4) break;
+                len = (q[2] << 8) | q[3];
+                cab = 4;
+            }
+            // O servidor nunca mascara nem manda quadros maiores que o buffer
+            if ((q[1] & 0x80) || len == 127 || cab + len > CORPO_INICIO) {
+                falhar(c, FALHA_STATUS, agora);
+                return;
+            }
+            if (c->corpo_len - pos < cab + len) break;
+
+            uint8_t opcode = q[0] & 0x0F;
+            if (opcode == 0x8) {
+                falhar(c, FALHA_FECHADA, agora);
+                return;
+            }
+            if (opcode == 0x2 && len >= 4) {
+                uint32_t seq = q[cab] | (q[cab + 1] << 8) | (q[cab + 2] << 16) | ((uint32_t)q[cab + 3] << 24);
+                if (c->seq && seq > c->seq + 1) amostras_perdidas += seq - c->seq - 1;
+                if (c->quadro_us) acrescentar(&intervalos, agora - c->quadro_us);
+                c->seq = seq;
+                c->quadro_us = agora;
+                c->inicio_us = agora; // O timeout conta a partir do último quadro
+                quadros_ws++;
+                bytes_ws += cab + len;
+            }
+            pos += cab + len;
+        }
+        memmove(c->corpo, c->corpo + pos, c->corpo_len - pos);
+        c->corpo_len -= pos;
+    }
+}
+
+static void receber(struct cliente *c, uint64_t agora) {
+    char buf[4096];
+    ssize_t n = recv(c->fd, buf, sizeof(buf), 0);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+    if (n <= 0) {
+        // Sem Content-Length nem chunked, o fechamento marca o fim do corpo
+        if (n == 0 && c->fase == FASE_CORPO && c->restante < 0 && !c->chunked) {
+            fechar(c);
+            concluir(c, agora);
+        } else {
+            falhar(c, c->fase == FASE_CABECALHO && c->cab_len == 0 && n < 0 ? FALHA_CONEXAO : FALHA_FECHADA, agora);
+        }
+        return;
+    }
+
+    long pos = 0;
+    if (c->fase == FASE_CABECALHO) {
+        while (pos < n && c->fase == FASE_CABECALHO) {
+            if (c->cab_len == CABECALHO_MAX - 1) {
+                falhar(c, FALHA_STATUS, agora);
+                return;
+            }
+            c->cab[c->cab_len++] = buf[pos++];
+            if (c->cab_len >= 4 && !memcmp(c->cab + c->cab_len - 4, "\r\n\r\n", 4)) {
+                if (!ler_cabecalho(c)) {
+                    falhar(c, FALHA_STATUS, agora);
+                    return;
+                }
+                if (modo_ws) {
+                    acrescentar(&handshakes, agora - c->inicio_us);
+                    c->fase = FASE_WS;
+                    c->inicio_us = agora;
+                    c->quadro_us = 0;
+                    break;
+                }
+                c->fase = FASE_CORPO;
+                if (c->restante == 0) {
+                    concluir(c, agora);
+                    return;
+                }
+            }
+        }
+    }
+    if (c->fase == FASE_CORPO && ler_corpo(c, buf + pos, n - pos)) {
+        concluir(c, agora);
+    } else if (c->fase == FASE_WS) {
+        ler_quadros(c, buf + pos, n - pos, agora);
+    }
+}
+
+static void enviar(struct cliente *c, uint64_t agora) {
+    if (c->fase == FASE_CONECTANDO) {
+        int erro = 0;
+        socklen_t len = sizeof(erro);
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &erro, &len);
+        if (erro) {
+            falhar(c, FALHA_CONEXAO, agora);
+            return;
+        }
+        c->fase = FASE_ENVIANDO;
+    }
+
+    ssize_t n = send(c->fd, c->req + c->enviado, c->req_len - c->enviado, MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) falhar(c, FALHA_CONEXAO, agora);
+        return;
+    }
+    c->enviado += n;
+    if (c->enviado == c->req_len) c->fase = FASE_CABECALHO;
+}
+
+// Relatório de memória do servidor, lido numa conexão própria depois do teste
+static void mostrar_memoria(void) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct timeval tv = { 2, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    if (connect(fd, (struct sockaddr *)&destino, sizeof(destino)) < 0) {
+        close(fd);
+        return;
+    }
+    const char req[] = "GET /mem HTTP/1.1\r\nConnection: close\r\n\r\n";
+    send(fd, req, sizeof(req) - 1, MSG_NOSIGNAL);
+
+    static char resp[8192];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(resp) - 1 && (n = recv(fd, resp + len, sizeof(resp) - 1 - len, 0)) > 0) {
+        len += n;
+    }
+    close(fd);
+    resp[len] = '\0';
+
+    char *corpo = strstr(resp, "\r\n\r\n");
+    if (!strncmp(resp, "HTTP/1.1 200", 12) && corpo) {
+        printf("\nMemoria do servidor (/mem):\n%s", corpo + 4);
+    }
+}
+
+static void uso(const char *nome) {
+    fprintf(stderr, "uso: %s [-h host] [-p porta] [-c clientes] [-d segundos] [-m pagina:estado:limites]\n"
+                    "          [-w espera_ms] [-k 0|1] [-t timeout_ms] [-W]\n", nome);
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "h:p:c:d:m:w:k:t:W")) != -1) {
+        switch (opt) {
+            case 'h': host = optarg; break;
+            case 'p': porta = atoi(optarg); break;
+            case 'c': num_clientes = atoi(optarg); break;
+            case 'd': duracao_s = atoi(optarg); break;
+            case 'm':
+                if (sscanf(optarg, "%d:%d:%d", &pesos[0], &pesos[1], &pesos[2]) != 3) uso(argv[0]);
+                break;
+            case 'w': espera_ms = atoi(optarg); break;
+            case 'k': keep_alive = atoi(optarg) != 0; break;
+            case 't': timeout_ms = atoi(optarg); break;
+            case 'W': modo_ws = true; break;
+            default: uso(argv[0]);
+        }
+    }
+    if (num_clientes < 1 || num_clientes > MAX_CLIENTES || pesos[0] + pesos[1] + pesos[2] <= 0 ||
+        pesos[0] < 0 || pesos[1] < 0 || pesos[2] < 0) {
+        uso(argv[0]);
+    }
+
+    struct addrinfo dica = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM }, *res;
+    if (getaddrinfo(host, NULL, &dica, &res) != 0) {
+        fprintf(stderr, "Host desconhecido: %s\n", host);
+        return 1;
+    }
+    destino = *(struct sockaddr_in *)res->ai_addr;
+    destino.sin_port = htons(porta);
+    freeaddrinfo(res);
+    srand(1);
+
+    uint64_t inicio = agora_us();
+    uint64_t fim = inicio + duracao_s * 1000000ull;
+    for (int i = 0; i < num_clientes; i++) {
+        clientes[i].fd = -1;
+        agendar(&clientes[i], inicio);
+        clientes[i].proxima_us = inicio; // Todos começam juntos
+    }
+
+    uint64_t agora;
+    while ((agora = agora_us()) < fim) {
+        struct pollfd fds[MAX_CLIENTES];
+        for (int i = 0; i < num_clientes; i++) {
+            struct cliente *c = &clientes[i];
+            if (c->fase == FASE_ESPERA && agora >= c->proxima_us) iniciar(c, agora);
+
+            // Requisição sem resposta (ou WebSocket sem quadros) há timeout_ms
+            if (c->fase != FASE_ESPERA && agora - c->inicio_us > timeout_ms * 1000ull) {
+                falhar(c, FALHA_TIMEOUT, agora);
+            }
+
+            short ev = 0;
+            if (c->fase == FASE_CONECTANDO || c->fase == FASE_ENVIANDO) ev = POLLOUT;
+            else if (c->fase == FASE_CABECALHO || c->fase == FASE_CORPO || c->fase == FASE_WS) ev = POLLIN;
+            fds[i] = (struct pollfd){ .fd = ev ? c->fd : -1, .events = ev };
+        }
+
+        if (poll(fds, num_clientes, 10) < 0 && errno != EINTR) break;
+
+        agora = agora_us();
+        for (int i = 0; i < num_clientes; i++) {
+            struct cliente *c = &clientes[i];
+            if (fds[i].fd < 0 || fds[i].fd != c->fd || !fds[i].revents) continue;
+            if (fds[i].events & POLLOUT) {
+                enviar(c, agora);
+            } else {
+                receber(c, agora);
+            }
+        }
+    }
+    double segundos = (agora_us() - inicio) / 1e6;
+    for (int i = 0; i < num_clientes; i++) fechar(&clientes[i]);
+
+    size_t total = 0;
+    uint32_t total_falhas = 0;
+    struct amostras todas = { 0 };
+    for (int r = 0; r < NUM_ROTAS; r++) {
+        for (size_t i = 0; i < latencias[r].n; i++) {
+            acrescentar(&todas, latencias[r].us[i]);
+        }
+        total += latencias[r].n;
+        qsort(latencias[r].us, latencias[r].n, sizeof(uint32_t), comparar);
+    }
+    qsort(todas.us, todas.n, sizeof(uint32_t), comparar);
+    for (int f = 0; f < NUM_FALHAS; f++) total_falhas += falhas[f];
+
+    if (modo_ws) {
+        qsort(handshakes.us, handshakes.n, sizeof(uint32_t), comparar);
+        qsort(intervalos.us, intervalos.n, sizeof(uint32_t), comparar);
+        printf("%d clientes WebSocket (/ws), %.1f s\n", num_clientes, segundos);
+        printf("handshakes: %zu, p50 %.2f ms, p99 %.2f ms\n", handshakes.n,
+               percentil(&handshakes, 0.50) / 1000.0, percentil(&handshakes, 0.99) / 1000.0);
+        printf("quadros: %llu, %.1f/s (%.2f/s por cliente), %.1f bytes por quadro\n", (unsigned long long)quadros_ws,
+               quadros_ws / segundos, quadros_ws / segundos / num_clientes, quadros_ws ? (double)bytes_ws / quadros_ws : 0.0);
+        printf("intervalo entre quadros: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", percentil(&intervalos, 0.50) / 1000.0,
+               percentil(&intervalos, 0.99) / 1000.0, intervalos.n ? intervalos.us[intervalos.n - 1] / 1000.0 : 0.0);
+        printf("amostras perdidas: %llu\n", (unsigned long long)amostras_perdidas);
+    } else {
+        printf("%d clientes, %.1f s, mistura %d:%d:%d, keep-alive %s\n",
+               num_clientes, segundos, pesos[0], pesos[1], pesos[2], keep_alive ? "sim" : "nao");
+        printf("%-10s %8s %10s %10s %10s %10s\n", "rota", "req", "req/s", "p50 ms", "p99 ms", "max ms");
+        for (int r = 0; r < NUM_ROTAS; r++) {
+            const struct amostras *a = &latencias[r];
+            printf("%-10s %8zu %10.1f %10.2f %10.2f %10.2f\n", nomes_rotas[r], a->n, a->n / segundos,
+                   percentil(a, 0.50) / 1000.0, percentil(a, 0.99) / 1000.0, a->n ? a->us[a->n - 1] / 1000.0 : 0.0);
+        }
+        printf("%-10s %8zu %10.1f %10.2f %10.2f %10.2f\n", "total", total, total / segundos,
+               percentil(&todas, 0.50) / 1000.0, percentil(&todas, 0.99) / 1000.0, todas.n ? todas.us[todas.n - 1] / 1000.0 : 0.0);
+    }
+
+    printf("conexoes abertas: %lu\n", (unsigned long)conexoes_abertas);
+    printf("falhas: %lu", (unsigned long)total_falhas);
+    for (int f = 0; f < NUM_FALHAS; f++) {
+        if (falhas[f]) printf(", %s %lu", nomes_falhas[f], (unsigned long)falhas[f]);
+    }
+    for (int s = 1; s < 6; s++) {
+        if (status_falhas[s]) printf(" (%dxx: %lu)", s, (unsigned long)status_falhas[s]);
+    }
+    printf("\n");
+
+    mostrar_memoria();
+    return total_falhas ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+/**
+ * Comparação do desenho no framebuffer do display (lib/ssd1306.c) com o desenho pixel a pixel.
+ *
+ * As funções pixel_* abaixo reproduzem o desenho anterior ao blitter por bytes: tudo passa por
+ * ssd1306_pixel(), um bit de cada vez. O teste desenha as telas da estação nas duas cores e
+ * formas e caracteres sorteados com as duas implementações, exige framebuffers e regiões
+ * alteradas idênticos, e então mede o tempo de CPU por tela de cada uma.
+ *
+ * Uso: oled_bench [-n formas_sorteadas] [-q quadros_medidos]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ssd1306.h"
+#include "font.h"
+#include "hardware/dma.h"
+
+static ssd1306_t blitter, pixels;
+
+// ======== PERIFÉRICOS: o envio não é medido, então I2C e DMA não fazem nada ===========
+
+static i2c_hw_t i2c_regs = { .status = I2C_IC_STATUS_TFE_BITS };
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) { return &i2c_regs; }
+unsigned int i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) { return 0; }
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) { return (int)len; }
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) { return (int)len; }
+void sleep_ms(uint32_t ms) {}
+
+int dma_claim_unused_channel(bool required) { return 0; }
+dma_channel_config dma_channel_get_default_config(unsigned int channel) { return (dma_channel_config){ 0 }; }
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {}
+void channel_config_set_read_increment(dma_channel_config *c, bool incr) {}
+void channel_config_set_write_increment(dma_channel_config *c, bool incr) {}
+void channel_config_set_dreq(dma_channel_config *c, unsigned int dreq) {}
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, unsigned int transfer_count, bool trigger) {}
+void dma_channel_transfer_from_buffer_now(unsigned int channel, const volatile void *read_addr, uint32_t transfer_count) {}
+bool dma_channel_is_busy(unsigned int channel) { return false; }
+
+// ======== DESENHO PIXEL A PIXEL (referência) ===========
+
+static void pixel_fill(ssd1306_t *ssd, bool value) {
+    for (uint8_t y = 0; y < ssd->height; ++y)
+        for (uint8_t x = 0; x < ssd->width; ++x)
+            ssd1306_pixel(ssd, x, y, value);
+}
+
+static void pixel_rect(ssd1306_t *ssd, uint8_t top, uint8_t left, uint8_t width, uint8_t height, bool value, bool fill) {
+    for (uint8_t x = left; x < left + width; ++x) {
+        ssd1306_pixel(ssd, x, top, value);
+        ssd1306_pixel(ssd, x, top + height - 1, value);
+    }
+    for (uint8_t y = top; y < top + height; ++y) {
+        ssd1306_pixel(ssd, left, y, value);
+        ssd1306_pixel(ssd, left + width - 1, y, value);
+    }
+    if (fill) {
+        for (uint8_t x = left + 1; x < left + width - 1; ++x)
+            for (uint8_t y = top + 1; y < top + height - 1; ++y)
+                ssd1306_pixel(ssd, x, y, value);
+    }
+}
+
+static void pixel_line(ssd1306_t *ssd, uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool value) {
+    int dx = abs(x1 - x0), dy = abs(y1 - y0);
+    int sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+    int err = dx - dy;
+    while (true) {
+        ssd1306_pixel(ssd, x0, y0, value);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = err * 2;
+        if (e2 > -dy) { err -= dy; x0 += sx; }
+        if (e2 < dx) { err += dx; y0 += sy; }
+    }
+}
+
+static void pixel_hline(ssd1306_t *ssd, uint8_t x0, uint8_t x1, uint8_t y, bool value) {
+    for (uint8_t x = x0; x <= x1; ++x) ssd1306_pixel(ssd, x, y, value);
+}
+
+static void pixel_vline(ssd1306_t *ssd, uint8_t x, uint8_t y0, uint8_t y1, bool value) {
+    for (uint8_t y = y0; y <= y1; ++y) ssd1306_pixel(ssd, x, y, value);
+}
+
+static void pixel_draw_char(ssd1306_t *ssd, char c, uint8_t x, uint8_t y) {
+    uint16_t index = (c >= ' ' && c <= '~') ? (c - ' ') * 8 : 0;
+    for (uint8_t i = 0; i < 8; ++i)
+        for (uint8_t j = 0; j < 8; ++j)
+            ssd1306_pixel(ssd, x + i, y + j, font[index + i] & (1 << j));
+}
+
+static void pixel_draw_string(ssd1306_t *ssd, const char *str, uint8_t x, uint8_t y) {
+    while (*str) {
+        pixel_draw_char(ssd, *str++, x, y);
+        x += 8;
+        if (x + 8 >= ssd->width) { x = 0; y += 8; }
+        if (y + 8 >= ssd->height) break;
+    }
+}
+
+// ======== TELAS E COMPARAÇÃO ===========
+
+// Chama a função do blitter (ssd1306_*) ou a de referência (pixel_*) com os mesmos argumentos
+#define DESENHAR(ref, fn, ...) ((ref) ? pixel_##fn(__VA_ARGS__) : ssd1306_##fn(__VA_ARGS__))
+
+// As telas do laço principal da estação, com valores típicos
+static void desenhar_tela(ssd1306_t *s, bool ref, int tela, bool cor) {
+    DESENHAR(ref, fill, s, !cor);
+    DESENHAR(ref, rect, s, 3, 3, 122, 60, cor, !cor);
+    DESENHAR(ref, draw_string, s, "WEA. STATION", 16, 8);
+    DESENHAR(ref, draw_string, s, "IP:", 6, 16);
+    DESENHAR(ref, draw_string, s, "192.168.0.123", 32, 16);
+    DESENHAR(ref, line, s, 3, 26, 123, 26, cor);
+    switch (tela) {
+        case 0:
+            DESENHAR(ref, draw_string, s, "TEMP:", 24, 32);
+            DESENHAR(ref, draw_string, s, "25.3C", 65, 32);
+            break;
+        case 1:
+            DESENHAR(ref, draw_string, s, "HUM:", 24, 32);
+            DESENHAR(ref, draw_string, s, "55.2%", 57, 32);
+            break;
+        case 2:
+            DESENHAR(ref, draw_string, s, "PRESS:", 8, 32);
+            DESENHAR(ref, draw_string, s, "101.3kPa", 60, 32);
+            DESENHAR(ref, draw_string, s, "ALT:", 8, 42);
+            DESENHAR(ref, draw_string, s, "12.0m", 49, 42);
+            break;
+        default:
+            DESENHAR(ref, line, s, 63, 25, 63, 60, cor);
+            DESENHAR(ref, draw_string, s, "TEMP:", 12, 30);
+            DESENHAR(ref, draw_string, s, "25.3C", 73, 30);
+            DESENHAR(ref, draw_string, s, "HUM:", 12, 40);
+            DESENHAR(ref, draw_string, s, "55%", 73, 40);
+            DESENHAR(ref, draw_string, s, "PRESS:", 12, 50);
+            DESENHAR(ref, draw_string, s, "101", 64, 50);
+            break;
+    }
+}
+
+// Uma forma sorteada, dentro da tela, desenhada com as duas implementações
+static void desenhar_sorteada(void) {
+    uint8_t x = rand() % WIDTH, y = rand() % HEIGHT, x2 = rand() % WIDTH, y2 = rand() % HEIGHT;
+    uint8_t w = 1 + rand() % (WIDTH - x), h = 1 + rand() % (HEIGHT - y);
+    bool v = rand() % 2, f = rand() % 2;
+    switch (rand() % 5) {
+        case 0:
+            ssd1306_rect(&blitter, y, x, w, h, v, f);
+            pixel_rect(&pixels, y, x, w, h, v, f);
+            break;
+        case 1:
+            if (x > x2) { uint8_t t = x; x = x2; x2 = t; }
+            ssd1306_hline(&blitter, x, x2, y, v);
+            pixel_hline(&pixels, x, x2, y, v);
+            break;
+        case 2:
+            if (y > y2) { uint8_t t = y; y = y2; y2 = t; }
+            ssd1306_vline(&blitter, x, y, y2, v);
+            pixel_vline(&pixels, x, y, y2, v);
+            break;
+        case 3:
+            ssd1306_line(&blitter, x, y, x2, y2, v);
+            pixel_line(&pixels, x, y, x2, y2, v);
+            break;
+        default:
+            if (x <= WIDTH - 8 && y <= HEIGHT - 8) {
+                char c = ' ' + rand() % 95;
+                ssd1306_draw_char(&blitter, c, x, y);
+                pixel_draw_char(&pixels, c, x, y);
+            }
+            break;
+    }
+}
+
+static bool iguais(void) {
+    return memcmp(blitter.ram_buffer, pixels.ram_buffer, blitter.bufsize) == 0 &&
+           memcmp(blitter.dirty_min, pixels.dirty_min, sizeof(blitter.dirty_min)) == 0 &&
+           memcmp(blitter.dirty_max, pixels.dirty_max, sizeof(blitter.dirty_max)) == 0;
+}
+
+static double agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    long sorteadas = 200000, quadros = 20000;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:q:")) != -1) {
+        switch (opt) {
+            case 'n': sorteadas = atol(optarg); break;
+            case 'q': quadros = atol(optarg); break;
+            default:
+                fprintf(stderr, "uso: %s [-n formas_sorteadas] [-q quadros_medidos]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (quadros < 1) quadros = 1;
+
+    ssd1306_init(&blitter, WIDTH, HEIGHT, false, 0x3C, NULL);
+    ssd1306_init(&pixels, WIDTH, HEIGHT, false, 0x3C, NULL);
+
+    for (int tela = 0; tela < 4; tela++) {
+        for (int cor = 0; cor < 2; cor++) {
+            desenhar_tela(&blitter, false, tela, cor);
+            desenhar_tela(&pixels, true, tela, cor);
+            if (!iguais()) {
+                fprintf(stderr, "framebuffers diferentes na tela %d, cor %d\n", tela, cor);
+                return 1;
+            }
+        }
+    }
+    srand(1);
+    for (long i = 0; i < sorteadas; i++) {
+        desenhar_sorteada();
+        if (!iguais()) {
+            fprintf(stderr, "framebuffers diferentes na forma sorteada %ld\n", i);
+            return 1;
+        }
+    }
+
+    double t0 = agora_ns();
+    for (long i = 0; i < quadros; i++) desenhar_tela(&pixels, true, i & 3, i & 4);
+    double t1 = agora_ns();
+    for (long i = 0; i < quadros; i++) desenhar_tela(&blitter, false, i & 3, i & 4);
+    double t2 = agora_ns();
+
+    printf("%ld formas sorteadas identicas; pixel a pixel: %.1f us/tela, blitter: %.1f us/tela\n",
+           sorteadas, (t1 - t0) / quadros / 1e3, (t2 - t1) / quadros / 1e3);
+    return 0;
+}
@@ -0,0 +1,339 @@
+/**
+ * Reprodução de uma gravação de sensores (lib/sensor_trace.h) no computador.
+ *
+ * As transações I2C gravadas alimentam o mesmo código do firmware: bmp280_init e
+ * bmp280_get_calib_params na inicialização e, a cada amostra, bmp280_read_raw, a compensação,
+ * bmp280_altitude e aht20_read. Cada sensor tem a sua fila de transações; uma escrita ou leitura
+ * diferente da gravada é uma divergência e interrompe a reprodução. As esperas (sleep_ms) só
+ * avançam o relógio, então dias de gravação rodam em segundos.
+ *
+ * Uso: replay [-n repeticoes] [-b] [-g referencia.csv] gravacao.txt
+ *   Sem -b, escreve uma linha CSV por amostra; com -g, compara com um CSV gerado antes (saída de
+ *   referência) e termina com erro na primeira diferença. -b só mede o tempo por amostra.
+ *   Para gravar: configure o firmware com cmake -DSTATION_TRACE=ON e capture a USB, por exemplo
+ *   cat /dev/ttyACM0 > gravacao.txt (as linhas que não começam com "#I2C" são ignoradas).
+ */
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#include "aht20.h"
+#include "bmp280.h"
+#include "sensor_trace.h"
+
+#define LINHA_MAX 256
+
+enum tipo_entrada {
+    ENTRADA_TRANSACAO,
+    ENTRADA_BOOT,     // Início de uma captura: seguem as transações da inicialização
+    ENTRADA_LOOP,     // Fim da inicialização
+    ENTRADA_LACUNA    // Transações perdidas pelo firmware
+};
+
+typedef struct {
+    enum tipo_entrada tipo;
+    unsigned linha;   // Linha no arquivo, para as mensagens de divergência
+    uint64_t t_us;
+    char rw;          // 'R' ou 'W'
+    uint8_t addr;
+    int ret;
+    uint8_t len;
+    uint8_t data[SENSOR_TRACE_DATA_MAX];
+} entrada_t;
+
+// Transações de um sensor, na ordem em que o firmware as fez
+typedef struct {
+    uint8_t addr;
+    const entrada_t **v;
+    size_t n, cap, pos;
+} fila_t;
+
+static entrada_t *entradas;
+static size_t num_entradas;
+
+static fila_t filas[2] = { { AHT20_I2C_ADDR }, { ADDR } };
+static jmp_buf fim_da_fila;   // Uma fila acabou no meio de uma amostra
+static uint64_t relogio_us;   // Horário da última transação consumida
+
+// ======== I2C E TEMPO GRAVADOS ===========
+
+void sleep_ms(uint32_t ms) {
+    (void)ms;
+}
+
+static fila_t *fila_de(uint8_t addr) {
+    for (int i = 0; i < 2; i++) {
+        if (filas[i].addr == addr) return &filas[i];
+    }
+    fprintf(stderr, "Endereco I2C %02x nao gravado\n", addr);
+    exit(1);
+}
+
+static const entrada_t *proxima(uint8_t addr, char rw) {
+    fila_t *f = fila_de(addr);
+    if (f->pos == f->n) longjmp(fim_da_fila, 1);
+
+    const entrada_t *e = f->v[f->pos++];
+    if (e->rw != rw) {
+        fprintf(stderr, "Divergencia na linha %u: o codigo fez %c em %02x, a gravacao tem %c\n", e->linha, rw, addr, e->rw);
+        exit(1);
+    }
+    relogio_us = e->t_us;
+    return e;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    const entrada_t *e = proxima(addr, 'W');
+    if (e->len != len || memcmp(e->data, src, len) != 0) {
+        fprintf(stderr, "Divergencia na linha %u: escrita em %02x com outros bytes\n", e->linha, addr);
+        exit(1);
+    }
+    return e->ret;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    const entrada_t *e = proxima(addr, 'R');
+    if (e->ret >= 0 && e->len != len) {
+        fprintf(stderr, "Divergencia na linha %u: leitura de %zu bytes em %02x, a gravacao tem %u\n", e->linha, len, addr, e->len);
+        exit(1);
+    }
+    memcpy(dst, e->data, e->len);
+    return e->ret;
+}
+
+// ======== GRAVAÇÃO ===========
+
+static void acrescentar(const entrada_t *e) {
+    if (num_entradas % 4096 == 0) {
+        entradas = realloc(entradas, (num_entradas + 4096) * sizeof(entrada_t));
+    }
+    entradas[num_entradas++] = *e;
+}
+
+static void ler_gravacao(const char *caminho) {
+    FILE *f = fopen(caminho, "r");
+    if (!f) {
+        perror(caminho);
+        exit(1);
+    }
+
+    char linha[LINHA_MAX];
+    unsigned num = 0;
+    while (fgets(linha, sizeof(linha), f)) {
+        num++;
+        if (strncmp(linha, "#I2C ", 5) != 0) continue;
+
+        entrada_t e = { .linha = num };
+        char hex[2 * SENSOR_TRACE_DATA_MAX + 2] = "";
+        unsigned long long t;
+        unsigned addr;
+        if (!strncmp(linha + 5, "boot", 4)) {
+            e.tipo = ENTRADA_BOOT;
+        } else if (!strncmp(linha + 5, "loop", 4)) {
+            e.tipo = ENTRADA_LOOP;
+        } else if (!strncmp(linha + 5, "perdidos", 8)) {
+            e.tipo = ENTRADA_LACUNA;
+        } else if (sscanf(linha + 5, "%llu %c %x %d %49s", &t, &e.rw, &addr, &e.ret, hex) >= 4) {
+            e.tipo = ENTRADA_TRANSACAO;
+            e.t_us = t;
+            e.addr = addr;
+            e.len = strlen(hex) / 2;
+            for (int i = 0; i < e.len; i++) {
+                sscanf(hex + 2 * i, "%2hhx", &e.data[i]);
+            }
+        } else {
+            fprintf(stderr, "%s:%u: linha invalida\n", caminho, num);
+            exit(1);
+        }
+        acrescentar(&e);
+    }
+    fclose(f);
+}
+
+// Distribui as transações de [inicio, fim) entre as filas dos sensores
+static void encher_filas(size_t inicio, size_t fim) {
+    for (int i = 0; i < 2; i++) {
+        filas[i].n = filas[i].pos = 0;
+    }
+    for (size_t i = inicio; i < fim; i++) {
+        fila_t *f = fila_de(entradas[i].addr);
+        if (f->n == f->cap) {
+            f->cap = f->cap ? 2 * f->cap : 1024;
+            f->v = realloc(f->v, f->cap * sizeof(*f->v));
+        }
+        f->v[f->n++] = &entradas[i];
+    }
+}
+
+// Depois de uma lacuna, cada fila recomeça na próxima escrita, que sempre abre uma leitura
+static void ressincronizar(void) {
+    for (int i = 0; i < 2; i++) {
+        while (filas[i].pos < filas[i].n && filas[i].v[filas[i].pos]->rw != 'W') filas[i].pos++;
+    }
+}
+
+// Fim do trecho que começa em inicio: o próximo marcador ou o fim do arquivo
+static size_t fim_do_trecho(size_t inicio) {
+    while (inicio < num_entradas && entradas[inicio].tipo == ENTRADA_TRANSACAO) inicio++;
+    return inicio;
+}
+
+// ======== AMOSTRAS ===========
+
+// Estado do laço principal do firmware: uma leitura com falha mantém o último valor
+typedef struct {
+    struct bmp280_calib_param params;
+    float temperature, humidity, pressure, aht_temperature;
+} estacao_t;
+
+static estacao_t estacao;
+static FILE *referencia;
+static bool medir;
+static unsigned long amostras, linha_saida;
+
+static void saida(const char *texto) {
+    linha_saida++;
+    if (!referencia) {
+        fputs(texto, stdout);
+        return;
+    }
+    char esperado[LINHA_MAX];
+    if (!fgets(esperado, sizeof(esperado), referencia) || strcmp(esperado, texto) != 0) {
+        fprintf(stderr, "Diferenca na linha %lu da referencia:\n  esperado: %s  obtido:   %s", linha_saida,
+                referencia && !feof(referencia) ? esperado : "(fim)\n", texto);
+        exit(1);
+    }
+}
+
+// Mesma sequência do laço principal. Retorna false se a gravação acabou antes do fim da amostra
+static bool amostrar(uint64_t deslocamento_us) {
+    if (setjmp(fim_da_fila)) return false;
+
+    int32_t raw_temp, raw_press;
+    bool bmp_ok = bmp280_read_raw(NULL, &raw_temp, &raw_press);
+    uint64_t t_us = relogio_us;
+    if (bmp_ok) {
+        estacao.temperature = (float) (bmp280_convert_temp(raw_temp, &estacao.params)) / 100.0;
+        estacao.pressure = (float) bmp280_convert_pressure(raw_press, raw_temp, &estacao.params) / 1000.0;
+    }
+    double altitude = bmp280_altitude(estacao.pressure * 1000);
+
+    AHT20_Data data;
+    bool aht_ok = aht20_read(NULL, &data);
+    if (aht_ok) {
+        estacao.humidity = data.humidity;
+        estacao.aht_temperature = data.temperature;
+    }
+
+    amostras++;
+    if (!medir) {
+        char texto[LINHA_MAX];
+        snprintf(texto, sizeof(texto), "%.3f,%.2f,%.3f,%.2f,%.2f,%.2f,%d,%d\n",
+                 (t_us + deslocamento_us) / 1e6, estacao.temperature, estacao.pressure, altitude,
+                 estacao.aht_temperature, estacao.humidity, bmp_ok, aht_ok);
+        saida(texto);
+    }
+    return true;
+}
+
+// Inicialização gravada. Só o BMP280 tem estado a recuperar; as transações do AHT20 são descartadas
+static void calibrar(unsigned linha) {
+    if (setjmp(fim_da_fila)) {
+        fprintf(stderr, "Linha %u: inicializacao do BMP280 incompleta\n", linha);
+        exit(1);
+    }
+    bmp280_init(NULL);
+    bmp280_get_calib_params(NULL, &estacao.params);
+}
+
+// Reproduz a gravação inteira uma vez. Retorna o intervalo de tempo coberto por ela
+static uint64_t reproduzir(uint64_t deslocamento_us) {
+    uint64_t primeiro = 0, ultimo = 0;
+    bool calibrado = false;
+
+    for (size_t i = 0; i < num_entradas; ) {
+        enum tipo_entrada marcador = entradas[i].tipo;
+        size_t inicio = marcador == ENTRADA_TRANSACAO ? i : i + 1;
+        size_t fim = fim_do_trecho(inicio);
+        encher_filas(inicio, fim);
+
+        if (marcador == ENTRADA_BOOT) {
+            calibrar(entradas[i].linha);
+            calibrado = true;
+        } else if (calibrado) {
+            if (marcador == ENTRADA_LACUNA) ressincronizar();
+            while (amostrar(deslocamento_us)) {
+                if (!primeiro) primeiro = relogio_us;
+                ultimo = relogio_us;
+            }
+        }
+        i = fim;
+    }
+
+    if (!calibrado) {
+        fprintf(stderr, "A gravacao nao tem a inicializacao (#I2C boot)\n");
+        exit(1);
+    }
+    return ultimo - primeiro;
+}
+
+static uint64_t agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    int repeticoes = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:bg:")) != -1) {
+        switch (opt) {
+            case 'n': repeticoes = atoi(optarg); break;
+            case 'b': medir = true; break;
+            case 'g':
+                referencia = fopen(optarg, "r");
+                if (!referencia) {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "uso: %s [-n repeticoes] [-b] [-g referencia.csv] gravacao.txt\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1 || repeticoes < 1) {
+        fprintf(stderr, "uso: %s [-n repeticoes] [-b] [-g referencia.csv] gravacao.txt\n", argv[0]);
+        return 2;
+    }
+
+    ler_gravacao(argv[optind]);
+
+    uint64_t inicio = agora_ns();
+    uint64_t gravado_us = 0;
+    for (int r = 0; r < repeticoes; r++) {
+        gravado_us += reproduzir(gravado_us);
+    }
+    uint64_t decorrido_ns = agora_ns() - inicio;
+
+    if (referencia) {
+        char resto[LINHA_MAX];
+        if (fgets(resto, sizeof(resto), referencia)) {
+            fprintf(stderr, "A referencia tem mais amostras que a reproducao (%lu)\n", amostras);
+            return 1;
+        }
+        fprintf(stderr, "%lu amostras iguais a referencia\n", amostras);
+    }
+    if (medir) {
+        printf("%lu amostras, %.1f h gravadas, reproduzidas em %.1f ms: %.3f us por amostra, %.0fx o tempo real\n",
+               amostras, gravado_us / 3.6e9, decorrido_ns / 1e6, amostras ? decorrido_ns / 1e3 / amostras : 0.0,
+               decorrido_ns ? gravado_us * 1e3 / decorrido_ns : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * Medição do motor de regras de alarme (lib/rules.c) no computador.
+ *
+ * Compila RULES_MAX regras aleatórias (o Makefile usa -DRULES_MAX=256, bem acima das 16 do
+ * firmware) com uma ou duas condições, taxa de variação e "for" sorteados, e mede o tempo de
+ * rules_evaluate() sobre uma série de amostras. Serve para conferir que a avaliação percorre só a
+ * tabela compilada, com custo proporcional ao número de condições.
+ *
+ * Uso: rules_bench [-n avaliacoes] [-s semente]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rules.h"
+
+#define TEXTO_MAX 80
+
+static rules_t regras;
+
+static double agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// Sorteia o texto de uma regra válida na sintaxe de rules.h
+static void sortear_regra(char *texto) {
+    static const char *canais[] = { "temp", "hum", "press" };
+    static const char *ops[] = { ">", "<", ">=", "<=" };
+    int n = snprintf(texto, TEXTO_MAX, "%s", rand() % 4 ? "" : "crit ");
+    int conds = 1 + rand() % 2;
+    for (int j = 0; j < conds; j++) {
+        n += snprintf(texto + n, TEXTO_MAX - n, "%s%s%s %s %d", j ? " and " : "", canais[rand() % 3],
+                      rand() % 5 ? "" : " rate", ops[rand() % 4], rand() % 100);
+    }
+    if (rand() % 2) snprintf(texto + n, TEXTO_MAX - n, " for %d", rand() % 120);
+}
+
+int main(int argc, char **argv) {
+    long avaliacoes = 20000;
+    unsigned semente = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': avaliacoes = atol(optarg); break;
+            case 's': semente = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "uso: %s [-n avaliacoes] [-s semente]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (avaliacoes < 1) avaliacoes = 1;
+
+    rules_init(&regras);
+    srand(semente);
+    char texto[TEXTO_MAX];
+    const char *erro;
+    while (regras.num_rules < RULES_MAX) {
+        sortear_regra(texto);
+        if (rules_add(&regras, texto, &erro) < 0) {
+            fprintf(stderr, "regra rejeitada [%s]: %s\n", texto, erro);
+            return 1;
+        }
+    }
+
+    // Uma amostra a cada 500 ms, com a temperatura variando para as regras mudarem de estado
+    float valores[RULES_NUM_CHANNELS] = { 20.0f, 40.0f, 100.0f };
+    volatile unsigned ativas = 0;
+    double t0 = agora_ns();
+    for (long i = 0; i < avaliacoes; i++) {
+        valores[RULES_TEMP] = 20.0f + (i % 100) * 0.1f;
+        ativas += rules_evaluate(&regras, valores, 1000 + (uint32_t)i * 500);
+    }
+    double t1 = agora_ns();
+
+    printf("%u regras, %u condicoes: %.2f us por avaliacao (%.1f ns por condicao)\n",
+           regras.num_rules, regras.num_conds, (t1 - t0) / avaliacoes / 1e3,
+           (t1 - t0) / avaliacoes / regras.num_conds);
+    return 0;
+}
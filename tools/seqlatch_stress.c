@@ -0,0 +1,126 @@
+/**
+ * Teste de estresse do seqlatch (lib/seqlatch.h) com threads de verdade no computador.
+ *
+ * Uma thread escritora publica amostras no mesmo formato do histórico do servidor web, enquanto
+ * leitoras em outras threads (e em outros núcleos, o que no Pico W nunca acontece) conferem cada
+ * cópia lida: a amostra s tem temperatura s, umidade 2s e pressão -s, e todas as amostras do
+ * anel precisam ser da mesma publicação. Uma cópia com valores de publicações diferentes é uma
+ * leitura rasgada e faz o teste falhar.
+ *
+ * Uso: seqlatch_stress [-n publicacoes] [-r leitoras] [-s]
+ *   -s lê o valor do escritor direto, sem o seqlatch, para mostrar que a verificação pega rasgos.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "seqlatch.h"
+
+#define MAX_LEITORAS 16
+#define N 20 // Amostras no anel, como WEBSERVER_MAX_SAMPLES
+
+typedef struct {
+    uint32_t seq;
+    float temperature[N];
+    float humidity[N];
+    float pressure[N];
+} amostras_t;
+
+static amostras_t escrita, copias[2];
+static seqlatch_t latch = SEQLATCH_INIT(&copias[0], &copias[1], sizeof(amostras_t));
+
+static uint32_t publicacoes = 5000000;
+static bool sem_latch = false;
+static atomic_bool fim;
+
+typedef struct {
+    pthread_t thread;
+    unsigned long leituras;
+    unsigned long rasgadas;
+} leitora_t;
+
+static void *escritor(void *arg) {
+    for (uint32_t s = 1; s <= publicacoes; s++) {
+        uint32_t i = (s - 1) % N;
+        escrita.temperature[i] = (float)s;
+        escrita.humidity[i] = 2.0f * s;
+        escrita.pressure[i] = -(float)s;
+        escrita.seq = s;
+        if (!sem_latch) seqlatch_publish(&latch, &escrita);
+    }
+    atomic_store(&fim, true);
+    return NULL;
+}
+
+// Confere se a cópia é de uma única publicação: as min(seq, N) últimas amostras, com os valores delas
+static bool consistente(const amostras_t *a) {
+    for (uint32_t k = 0; k < N && k < a->seq; k++) {
+        uint32_t s = a->seq - k;
+        uint32_t i = (s - 1) % N;
+        if (a->temperature[i] != (float)s || a->humidity[i] != 2.0f * s || a->pressure[i] != -(float)s) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *leitora(void *arg) {
+    leitora_t *l = arg;
+    amostras_t a;
+    uint32_t anterior = 0;
+
+    while (!atomic_load(&fim)) {
+        uint32_t seq;
+        if (sem_latch) {
+            memcpy(&a, (const void *)&escrita, sizeof(a));
+            seq = a.seq;
+        } else {
+            seq = seqlatch_read(&latch, &a);
+        }
+        l->leituras++;
+        // Acima de 2^24 o float não representa s exatamente; o teste não chega lá com o padrão
+        if (seq != a.seq || a.seq < anterior || !consistente(&a)) l->rasgadas++;
+        anterior = a.seq;
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    int num_leitoras = 4;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:s")) != -1) {
+        switch (opt) {
+            case 'n': publicacoes = strtoul(optarg, NULL, 10); break;
+            case 'r': num_leitoras = atoi(optarg); break;
+            case 's': sem_latch = true; break;
+            default:
+                fprintf(stderr, "uso: %s [-n publicacoes] [-r leitoras] [-s]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (num_leitoras < 1 || num_leitoras > MAX_LEITORAS) num_leitoras = MAX_LEITORAS;
+    if (publicacoes > (1u << 24)) publicacoes = 1u << 24;
+
+    leitora_t leitoras[MAX_LEITORAS] = { 0 };
+    pthread_t t_escritor;
+    for (int i = 0; i < num_leitoras; i++) {
+        pthread_create(&leitoras[i].thread, NULL, leitora, &leitoras[i]);
+    }
+    pthread_create(&t_escritor, NULL, escritor, NULL);
+    pthread_join(t_escritor, NULL);
+
+    unsigned long leituras = 0, rasgadas = 0;
+    for (int i = 0; i < num_leitoras; i++) {
+        pthread_join(leitoras[i].thread, NULL);
+        leituras += leitoras[i].leituras;
+        rasgadas += leitoras[i].rasgadas;
+    }
+
+    printf("%s: %lu publicacoes, %d leitoras, %lu leituras, %lu rasgadas\n",
+           sem_latch ? "sem seqlatch" : "seqlatch", (unsigned long)publicacoes, num_leitoras, leituras, rasgadas);
+    return sem_latch ? 0 : rasgadas != 0;
+}
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+Gera uma gravação sintética de sensores no formato de lib/sensor_trace.h, para testar tools/replay
+sem a placa. A calibração do BMP280 é o exemplo do datasheet (dig_T1 = 27504, ...) e as leituras
+brutas ficam em torno dos valores do exemplo, com ruído de semente fixa.
+
+A gravação cobre os casos que a reprodução precisa tratar: ruído da USB antes do início, a
+inicialização, o AHT20 ocupado por zero a duas consultas, uma falha de I2C no BMP280 (quarta
+amostra) e uma lacuna em que o firmware perdeu a escrita do BMP280.
+
+Uso: gerar_sintetica.py [amostras] > sintetica.txt
+"""
+import random
+import struct
+import sys
+
+BMP280 = 0x76
+AHT20 = 0x38
+
+random.seed(1)
+amostras = int(sys.argv[1]) if len(sys.argv) > 1 else 10
+linhas = []
+t = 1000000
+
+
+def transacao(tipo, endereco, retorno, dados=b''):
+    global t
+    t += random.randint(50, 400)
+    linhas.append("#I2C %d %s %02x %d %s" % (t, tipo, endereco, retorno, dados.hex()))
+
+
+def amostra(falha_bmp=False, ocupado=1):
+    global t
+    t += 500000
+    if falha_bmp:
+        transacao('W', BMP280, -1, bytes([0xF7]))
+    else:
+        transacao('W', BMP280, 1, bytes([0xF7]))
+        p, tt = 415148 + random.randint(-50, 50), 519888 + random.randint(-50, 50)
+        transacao('R', BMP280, 6, bytes([p >> 12, (p >> 4) & 0xFF, (p & 0xF) << 4,
+                                         tt >> 12, (tt >> 4) & 0xFF, (tt & 0xF) << 4]))
+    transacao('W', AHT20, 3, bytes([0xAC, 0x33, 0x00]))
+    for _ in range(ocupado):
+        transacao('R', AHT20, 1, bytes([0x9C]))
+    transacao('R', AHT20, 1, bytes([0x1C]))
+    h, te = 524288 + random.randint(-999, 999), 393216 + random.randint(-999, 999)
+    transacao('R', AHT20, 6, bytes([0x1C, h >> 12, (h >> 4) & 0xFF, ((h & 0xF) << 4) | (te >> 16),
+                                    (te >> 8) & 0xFF, te & 0xFF]))
+
+
+linhas.append("Pressao = 100.653 kPa")  # Texto comum da USB, ignorado pela reprodução
+linhas.append("#I2C boot")
+transacao('W', BMP280, 2, bytes([0xF5, ((4 << 5) | (5 << 2)) & 0xFC]))
+transacao('W', BMP280, 2, bytes([0xF4, (1 << 5) | (3 << 2) | 3]))
+transacao('W', BMP280, 1, bytes([0x88]))
+calibracao = struct.pack('<HhhHhhhhhhhh', 27504, 26435, -1000, 36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000)
+transacao('R', BMP280, 24, calibracao)
+transacao('W', AHT20, 1, bytes([0xBA]))
+transacao('W', AHT20, 3, bytes([0xBE, 0x08, 0x00]))
+transacao('R', AHT20, 1, bytes([0x18]))
+linhas.append("#I2C loop")
+
+for i in range(amostras):
+    amostra(falha_bmp=(i == 3), ocupado=i % 3)
+
+# Lacuna: a amostra seguinte perdeu a escrita do BMP280
+linhas.append("#I2C perdidos 1")
+transacao('R', BMP280, 6, bytes(6))
+amostra()
+
+print("\n".join(linhas))
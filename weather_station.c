@@ -19,32 +19,42 @@
 #include "pico/bootrom.h"
 #include "pico/cyw43_arch.h"
 #include "lib/webserver.h" 
+#include "wifi.h"
 #include "hardware/pio.h"
-#include "ws2812.pio.h"
+#include "ws2812.h"
+#include "led_anim.h"
+#include "alarm.h"
+#include "rules.h"
+#include "config.h"
+#include "metrics.h"
+#include "prof.h"
+#include "memstats.h"
+#include "sensor_trace.h"
+#include "events.h"
 #include "hardware/clocks.h"
 #include "hardware/i2c.h"
 #include "hardware/pwm.h"
 #include "aht20.h"
 #include "bmp280.h"
 #include "ssd1306.h"
-#include "font.h"
+#include "ui.h"
 #include <math.h>
 
 
 // =========== PINOS E DEFINIÇÔES =============
 
-// IP da placa Raspberry Pi Pico W
-static char ip_str[24];
-
 // Buzzer
 const uint8_t BUZZER_PIN = 21;
 const uint16_t PERIOD = 59609; // WRAP
 const float DIVCLK = 16.0; // Divisor inteiro
 static uint slice_21;
 const uint16_t dc_values[] = {PERIOD * 0.3, 0}; // Duty Cycle de 30% e 0%
+static alarm_beeper_t bipe; // Padrões de bipe por severidade do alarme
 
 #define MATRIX_PIN 7 // Matriz de LEDs
 #define NUM_LEDS 25
+static ws2812_t matriz;
+static led_anim_t animacao; // Quadros da matriz gerados por temporizador
 
 #define BUTTON_A 5 // Botão A
 #define BUTTON_B 6 // Botão B
@@ -57,47 +67,118 @@ volatile uint32_t last_time = 0; // Para debounce
 #define I2C_PORT i2c0               // i2c0 pinos 0 e 1, i2c1 pinos 2 e 3
 #define I2C_SDA 0                   // 0 ou 2
 #define I2C_SCL 1                   // 1 ou 3
-#define SEA_LEVEL_press_buffer 101325.0 // Pressão ao nível do mar em Pa
 // Display na I2C
 #define I2C_PORT_DISP i2c1
 #define I2C_SDA_DISP 14
 #define I2C_SCL_DISP 15
 #define endereco 0x3C
+#define OLED_MAX_FPS 10 // Taxa máxima de quadros do display, para não competir com a amostragem
+#define INTERVALO_AMOSTRA_MS 500 // Período de leitura dos sensores
+#define ESPERA_MAX_MS 1000 // Maior espera do laço principal por eventos
 
 // Níveis limite padrão de umidade em %
 #define HUM_MAX 90.0f
 #define HUM_MIN 70.0f
-// Definidos pelo usuário
-volatile float hum_max_user = HUM_MAX; 
-volatile float hum_min_user = HUM_MIN; 
 
 // Níveis limite padrão de temperatura em °C
 #define TEMP_MAX 35.0f
 #define TEMP_MIN 20.0f
-// Definidos pelo usuário
-volatile float temp_max_user = TEMP_MAX; 
-volatile float temp_min_user = TEMP_MIN; 
 
 // Níveis limite padrão de pressão atmosférica em kPa
-#define PRESS_MAX 20.0f
-#define PRESS_MIN 0.0f
-// Definidos pelo usuário
-volatile float press_max_user = PRESS_MAX;
-volatile float press_min_user = PRESS_MIN;
+#define PRESS_MAX 110.0f
+#define PRESS_MIN 80.0f
+
+// Limites definidos pelo usuário na interface web (/limites), gravados na flash.
+// Os padrões valem até a primeira alteração
+static const config_t config_padrao = {
+    .limits = {
+        [CONFIG_TEMP]  = { TEMP_MIN, TEMP_MAX },
+        [CONFIG_HUM]   = { HUM_MIN, HUM_MAX },
+        [CONFIG_PRESS] = { PRESS_MIN, PRESS_MAX },
+    },
+};
+config_store_t config;
+
+// Alarmes por grandeza: histerese, distância ao limite para alarme crítico, tempo mínimo ligado e desligado (ms)
+static alarm_channel_t alarme_temp = ALARM_CHANNEL(0.5f, 5.0f, 3000, 2000);   // °C
+static alarm_channel_t alarme_umi = ALARM_CHANNEL(2.0f, 10.0f, 3000, 2000);   // %
+static alarm_channel_t alarme_press = ALARM_CHANNEL(0.3f, 5.0f, 3000, 2000);  // kPa
+static alarm_channel_t alarme_regras = ALARM_CHANNEL(0.0f, 0.0f, 3000, 2000); // Severidade das regras configuradas
+
+// Regras de alarme configuráveis pela interface web (/regras)
+rules_t regras;
 
 // Seletor de tela no display
 // 0 para todos os dados, 1 para temperatura, 2 para umidade e 3 para pressão atmosférica 
 static volatile int select_screen = 0;
 
-// Dados de temperatura (BMP280), umidade (AHT20) e pressão atmosférica (BMP280) lidos
-#define MAX_BUFFER_SIZE 20 // Tamanho do buffer de leitura. Armazena até 20 amostras
-float temp_buffer[MAX_BUFFER_SIZE] = {0};
+// Dados de temperatura (BMP280), umidade (AHT20) e pressão atmosférica (BMP280) lidos.
+// O histórico para a interface web é mantido e publicado pelo webserver
 float temperature; // Medição atual de temperatura
-float hum_buffer[MAX_BUFFER_SIZE] = {0};
 float humidity; // Medição atual de umidade relativa do ar
-float press_buffer[MAX_BUFFER_SIZE] = {0};
 float pressure; // Medição atual de pressão atmosférica
-int buffer_index = 0; // Indíce do buffer. Atualiza para indicar o número da amostra atual
+uint32_t sample_seq = 0; // Número de sequência da última amostra, publicado junto com ela para a interface web
+
+// Contadores de saúde expostos em /metrics. Só o laço principal escreve; os coletores leem no contexto do lwIP
+#define SAUDE_INTERVALO_MS 10000 // Intervalo entre leituras do RSSI
+static uint32_t erros_aht20 = 0;     // Leituras com falha na I2C
+static uint32_t erros_bmp280 = 0;
+static uint32_t oled_quadros = 0;    // Quadros enviados ao display
+static uint32_t oled_bytes = 0;      // Bytes desses quadros na I2C
+static uint32_t oled_caracteres = 0; // Caracteres redesenhados
+static int32_t wifi_rssi = 0;        // dBm
+static uint32_t boot_amostra_ms = 0; // Do boot (o temporizador parte na inicialização do runtime) até a primeira amostra
+static metrics_histogram_t duracao_laco = METRICS_HISTOGRAM(8); // Iteração do laço principal em µs, sem a espera
+
+// TELAS DO DISPLAY
+// Campos de valor das telas
+enum {
+    CAMPO_IP,
+    CAMPO_TEMP,
+    CAMPO_UMI,
+    CAMPO_PRESS,        // Pressão com uma casa decimal
+    CAMPO_PRESS_RESUMO, // Pressão inteira, para a tela geral
+    CAMPO_ALT
+};
+
+// Elementos comuns a todas as telas: título, IP e linha separadora
+#define TELA_TITULO {16, 8, "WEA. STATION"}
+#define TELA_IP {CAMPO_IP, 4, 16, 15}
+#define TELA_SEPARADOR {3, 26, 123, 26}
+
+static const ui_line_t linhas_padrao[] = { TELA_SEPARADOR };
+static const ui_line_t linhas_geral[] = { TELA_SEPARADOR, {63, 25, 63, 60} };
+
+static const ui_label_t rotulos_geral[] = { TELA_TITULO, {12, 30, "TEMP:"}, {12, 40, "HUM:"}, {12, 50, "PRESS:"} };
+static const ui_field_t campos_geral[] = {
+    TELA_IP, {CAMPO_TEMP, 73, 30, 6}, {CAMPO_UMI, 73, 40, 6}, {CAMPO_PRESS_RESUMO, 64, 50, 7}
+};
+
+// Gráficos das amostras recentes nas telas de cada grandeza, abaixo do valor e dentro da moldura
+static ui_sparkline_t grafico_temp = UI_SPARKLINE(4, 123, 41, 61, 2.0f);   // Escala em passos de 2 °C
+static ui_sparkline_t grafico_umi = UI_SPARKLINE(4, 123, 41, 61, 5.0f);    // 5 %
+static ui_sparkline_t grafico_press = UI_SPARKLINE(4, 123, 47, 61, 0.5f);  // 0,5 kPa
+
+static const ui_label_t rotulos_temp[] = { TELA_TITULO, {24, 32, "TEMP:"} };
+static const ui_field_t campos_temp[] = { TELA_IP, {CAMPO_TEMP, 65, 32, 7} };
+
+static const ui_label_t rotulos_umi[] = { TELA_TITULO, {24, 32, "HUM:"} };
+static const ui_field_t campos_umi[] = { TELA_IP, {CAMPO_UMI, 57, 32, 7} };
+
+// Pressão e altitude sobem para abrir espaço ao gráfico
+static const ui_label_t rotulos_press[] = { TELA_TITULO, {8, 28, "PRESS:"}, {8, 37, "ALT:"} };
+static const ui_field_t campos_press[] = { TELA_IP, {CAMPO_PRESS, 60, 28, 8}, {CAMPO_ALT, 49, 37, 8} };
+
+#define TELA(linhas, rotulos, campos, grafico) { true, linhas, sizeof(linhas) / sizeof(linhas[0]), \
+    rotulos, sizeof(rotulos) / sizeof(rotulos[0]), campos, sizeof(campos) / sizeof(campos[0]), grafico }
+
+// Indexadas por select_screen: 0 geral, 1 temperatura, 2 umidade, 3 pressão
+static const ui_screen_t telas[] = {
+    TELA(linhas_geral, rotulos_geral, campos_geral, NULL),
+    TELA(linhas_padrao, rotulos_temp, campos_temp, &grafico_temp),
+    TELA(linhas_padrao, rotulos_umi, campos_umi, &grafico_umi),
+    TELA(linhas_padrao, rotulos_press, campos_press, &grafico_press)
+};
 
 
 
@@ -105,31 +186,20 @@ int buffer_index = 0; // Indíce do buffer. Atualiza para indicar o número da a
 
 // WEBSERVER
 /**
- * Inicializa o servidor web e mostra informações no display
+ * Liga o Wi-Fi e o servidor web sem esperar a conexão: o IP aparece no display quando a rede subir.
+ * Sem o chip Wi-Fi não há lwIP (nem o bloqueio que o laço usa), então só essa falha interrompe a execução
  */
 void inicializar_webserver(ssd1306_t *ssd) {
-    ssd1306_fill(ssd, false);
-    ssd1306_draw_string(ssd, "Conectando WiFi", 6, 22);
-    ssd1306_send_data(ssd);
-
-    if (!webserver_init()) {
-        printf("Falha ao iniciar o servidor web.\n");
+    if (!wifi_init()) {
         ssd1306_fill(ssd, false);
         ssd1306_draw_string(ssd, "WiFi: FALHA", 8, 22);
         ssd1306_send_data(ssd);
-        while(true); // Para execução em caso de falha
+        while(true); // Para execução em caso de falha do chip
     }
-    
-    // Obtém e exibe o IP
-    uint8_t *ip = (uint8_t *)&(cyw43_state.netif[0].ip_addr.addr);
-    snprintf(ip_str, sizeof(ip_str), "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
-    printf("IP: %s\n", ip_str);
 
-    ssd1306_fill(ssd, false);
-    ssd1306_draw_string(ssd, "IP:", 8, 6);
-    ssd1306_draw_string(ssd, ip_str, 8, 22);
-    ssd1306_send_data(ssd);
-    sleep_ms(3000); // Mostra o IP por 3 segundos
+    if (!webserver_init()) {
+        printf("Falha ao iniciar o servidor web.\n");
+    }
 }
 
 
@@ -147,81 +217,29 @@ void setup_buzzer(){
     pwm_set_wrap(slice_21, PERIOD);
     pwm_set_gpio_level(BUZZER_PIN, 0);
     pwm_set_enabled(slice_21, true);
+    alarm_beeper_init(&bipe, BUZZER_PIN, dc_values[0]);
 }
 
 
 // MATRIZ DE LEDS
 /**
- * Envia um pixel para a matriz WS2812
- */
-void ws2812_put_pixel(uint32_t pixel_grb) {
-    pio_sm_put_blocking(pio0, 0, pixel_grb << 8u);
-}
-
-/**
- * Converte valores RGB para formato u32 (GRB)
+ * Gradiente da umidade na matriz, sobre 0 a 100 %: vermelho nos extremos (seco abaixo de 30 %,
+ * úmido demais acima de 99 %) e azul na faixa normal, com transição entre eles
  */
-uint32_t urgb_u32(uint8_t r, uint8_t g, uint8_t b) {
-    return ((uint32_t)(g) << 16) | ((uint32_t)(r) << 8) | (uint32_t)(b);
-}
+static const led_anim_stop_t gradiente_umidade[] = {
+    {0.30f, 255, 0, 0},
+    {0.39f, 0, 0, 255},
+    {0.79f, 0, 0, 255},
+    {0.99f, 255, 0, 0},
+};
 
 /**
- * Atualiza a matriz de LEDs baseada no nível percentual
+ * Atualiza a matriz de LEDs com uma barra proporcional ao nível percentual, na cor do gradiente.
+ * A animação faz a transição até a nova barra
  */
 void update_matrix(float nivel_percentual) {
-    uint32_t frame[NUM_LEDS] = {0};  // Buffer com 25 LEDs apagados
-    uint32_t cor_azul = urgb_u32(0, 0, 4);
-    uint32_t cor_vermelha = urgb_u32(4, 0, 0);
-
-    // Define quais LEDs acender baseado no nível
-    if (nivel_percentual >= 20.0 && nivel_percentual <= 30.0) {
-        // Primeira linha (0-4) - vermelha (nível baixo)
-        for (int i = 0; i <= 4; i++) {
-            frame[i] = cor_vermelha;
-        }
-    }
-    else if (nivel_percentual > 30.0 && nivel_percentual <= 39.0) {
-        // Primeira linha - azul (nível OK)
-        for (int i = 0; i <= 4; i++) {
-            frame[i] = cor_azul;
-        }
-    }
-    else if (nivel_percentual > 39.0 && nivel_percentual <= 59.0) {
-        // Duas primeiras linhas - azul
-        for (int i = 0; i <= 9; i++) {
-            frame[i] = cor_azul;
-        }
-    }
-    else if (nivel_percentual > 59.0 && nivel_percentual <= 70.0) {
-        // Três primeiras linhas - azul
-        for (int i = 0; i <= 14; i++) {
-            frame[i] = cor_azul;
-        }
-    }
-    else if (nivel_percentual > 70.0 && nivel_percentual <= 79.0) {
-        // Três primeiras linhas - vermelha (nível alto)
-        for (int i = 0; i <= 14; i++) {
-            frame[i] = cor_azul;
-        }
-    }
-    else if (nivel_percentual > 79.0 && nivel_percentual <= 99.0) {
-        // Quatro primeiras linhas - vermelha
-        for (int i = 0; i <= 19; i++) {
-            frame[i] = cor_vermelha;
-        }
-    }
-    else if (nivel_percentual > 99.0) {
-        // Todas as linhas - vermelha (nível crítico)
-        for (int i = 0; i <= 24; i++) {
-            frame[i] = cor_vermelha;
-        }
-    }
-
-    // Envia o frame completo para a matriz WS2812
-    for (int i = 0; i < NUM_LEDS; i++) {
-        ws2812_put_pixel(frame[i]);
-    }
-    sleep_us(70);
+    led_anim_set_value(&animacao, nivel_percentual, 0.0f, 100.0f, gradiente_umidade,
+                       sizeof(gradiente_umidade) / sizeof(gradiente_umidade[0]));
 }
 
 // Inicializa os periféricos
@@ -245,10 +263,16 @@ void initialize_peripherals(ssd1306_t *ssd, struct bmp280_calib_param *params){
     setup_buzzer(); // Buzzer
 
     // Configuração da matriz de LEDs WS2812
-    PIO pio = pio0;
-    int sm = 0;
-    uint offset = pio_add_program(pio, &ws2812_program);
-    ws2812_program_init(pio, sm, offset, MATRIX_PIN, 800000, false);
+    ws2812_init(&matriz, pio0, 0, MATRIX_PIN, NUM_LEDS);
+    led_anim_init(&animacao, &matriz);
+
+    // I2C dos sensores, primeiro para o AHT20 reiniciar enquanto o resto é configurado
+    i2c_init(I2C_PORT, 400 * 1000);
+    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_SDA);
+    gpio_pull_up(I2C_SCL);
+    aht20_reset(I2C_PORT);
 
     // I2C do Display funcionando em 400Khz.
     i2c_init(I2C_PORT_DISP, 400 * 1000);
@@ -259,55 +283,144 @@ void initialize_peripherals(ssd1306_t *ssd, struct bmp280_calib_param *params){
     gpio_pull_up(I2C_SCL_DISP);                                        // Pull up the clock line                                                    // Inicializa a estrutura do display
     ssd1306_init(ssd, WIDTH, HEIGHT, false, endereco, I2C_PORT_DISP); // Inicializa o display
     ssd1306_config(ssd);                                              // Configura o display
+    ssd1306_set_frame_rate(ssd, OLED_MAX_FPS);                        // Limita a taxa de quadros do laço principal
     ssd1306_send_data(ssd);                                           // Envia os dados para o display
 
     // Limpa o display. O display inicia com todos os pixels apagados.
     ssd1306_fill(ssd, false);
     ssd1306_send_data(ssd);
 
-    // Inicializa o I2C
-    i2c_init(I2C_PORT, 400 * 1000);
-    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
-    gpio_pull_up(I2C_SDA);
-    gpio_pull_up(I2C_SCL);
-
     // Inicializa o BMP280
     bmp280_init(I2C_PORT);
     bmp280_get_calib_params(I2C_PORT, params);
 
-    // Inicializa o AHT20
-    aht20_reset(I2C_PORT);
+    // Inicializa o AHT20. O reset foi enviado antes do display, que cobre os 20 ms de espera dele
     aht20_init(I2C_PORT);
+}
 
+// Sinaliza o estado pelo LED RGB, pela matriz e pelo buzzer, com base nas medidas obtidas
+void state_measures(float temp_buffer, float hum_buffer, float press_buffer){
+    uint32_t agora = to_ms_since_boot(get_absolute_time());
+    alarm_severity_t severidade = ALARM_NONE, s;
+
+    // Cópia consistente dos limites: uma alteração pela web nunca aparece pela metade
+    config_t cfg;
+    config_get(&config, &cfg);
+    const config_limits_t *lim = cfg.limits;
+
+    s = alarm_channel_update(&alarme_temp, alarm_check_limits(&alarme_temp, temp_buffer, lim[CONFIG_TEMP].min, lim[CONFIG_TEMP].max), agora);
+    if (s > severidade) severidade = s;
+    s = alarm_channel_update(&alarme_umi, alarm_check_limits(&alarme_umi, hum_buffer, lim[CONFIG_HUM].min, lim[CONFIG_HUM].max), agora);
+    if (s > severidade) severidade = s;
+    s = alarm_channel_update(&alarme_press, alarm_check_limits(&alarme_press, press_buffer, lim[CONFIG_PRESS].min, lim[CONFIG_PRESS].max), agora);
+    if (s > severidade) severidade = s;
+
+    // As regras são alteradas pelo servidor web, no contexto do lwIP: avalia com ele bloqueado
+    const float valores[RULES_NUM_CHANNELS] = { temp_buffer, hum_buffer, press_buffer };
+    cyw43_arch_lwip_begin();
+    alarm_severity_t severidade_regras = rules_evaluate(&regras, valores, agora);
+    cyw43_arch_lwip_end();
+    s = alarm_channel_update(&alarme_regras, severidade_regras, agora);
+    if (s > severidade) severidade = s;
+
+    // LED vermelho com algum dado fora do intervalo limite, verde caso contrário
+    gpio_put(LED_RED_PIN, severidade != ALARM_NONE);
+    gpio_put(LED_GREEN_PIN, severidade == ALARM_NONE);
+    led_anim_set_alarm(&animacao, severidade != ALARM_NONE); // Matriz pisca enquanto houver alarme
+    alarm_beeper_set(&bipe, severidade); // Bipes tocados por alarme de hardware, sem bloquear o laço
 }
 
-// Função para calcular a altitude a partir da pressão atmosférica
-double calculate_altitude(double press_buffer)
-{
-    return 44330.0 * (1.0 - pow(press_buffer / SEA_LEVEL_press_buffer, 0.1903));
+
+
+// Leituras de saúde que custam mais (o RSSI é pedido ao chip Wi-Fi), feitas a cada SAUDE_INTERVALO_MS
+void update_health(uint32_t agora_ms) {
+    static uint32_t ultima = 0;
+    if (ultima && agora_ms - ultima < SAUDE_INTERVALO_MS) return;
+    ultima = agora_ms;
+
+    int32_t rssi;
+    if (!wifi_connected()) return;
+    cyw43_arch_lwip_begin();
+    if (cyw43_wifi_get_rssi(&cyw43_state, &rssi) == 0) wifi_rssi = rssi;
+    cyw43_arch_lwip_end();
 }
 
-// Sinaliza o estado pelo LED RGB, com base nas medidas obtidas
-void state_measures(float temp_buffer, float hum_buffer, float press_buffer){
 
-    // Acende o LED vermelho, caso os dados estejam fora do intervalo limite
-    if (temp_buffer > temp_max_user || temp_buffer < temp_min_user 
-        || hum_buffer > hum_max_user || hum_buffer < hum_min_user 
-        || press_buffer > press_max_user || press_buffer < press_min_user){
-        gpio_put(LED_RED_PIN, true);
-        gpio_put(LED_GREEN_PIN, false);
-        // Emite beep
-        pwm_set_gpio_level(BUZZER_PIN, dc_values[0]);
-        sleep_ms(100);
-        pwm_set_gpio_level(BUZZER_PIN, dc_values[1]);
+// ======== MÉTRICAS (/metrics) ===========
+// Cada parte cabe em METRICS_CHUNK_MAX; /metrics gera uma parte por vez, conforme a conexão esvazia
+
+static void coletar_medidas(metrics_writer_t *w) {
+    metrics_family(w, "station_temperature_celsius", "gauge", "Temperatura medida pelo BMP280");
+    metrics_float(w, "station_temperature_celsius", NULL, temperature);
+    metrics_family(w, "station_humidity_percent", "gauge", "Umidade relativa medida pelo AHT20");
+    metrics_float(w, "station_humidity_percent", NULL, humidity);
+    metrics_family(w, "station_pressure_kpa", "gauge", "Pressao atmosferica medida pelo BMP280");
+    metrics_float(w, "station_pressure_kpa", NULL, pressure);
+    metrics_family(w, "station_samples_total", "counter", "Amostras lidas dos sensores");
+    metrics_uint(w, "station_samples_total", NULL, sample_seq);
+}
+
+static void coletar_limites(metrics_writer_t *w) {
+    static const char *const nomes_alarmes[] = { "temp", "hum", "press", "regras" };
+    const alarm_channel_t *alarmes[] = { &alarme_temp, &alarme_umi, &alarme_press, &alarme_regras };
+    char labels[40];
+
+    config_t cfg;
+    config_get(&config, &cfg);
+    metrics_family(w, "station_config_version", "gauge", "Versao da configuracao de limites");
+    metrics_uint(w, "station_config_version", NULL, cfg.version);
+    metrics_family(w, "station_threshold", "gauge", "Limites configurados por canal");
+    for (int i = 0; i < CONFIG_NUM_CHANNELS; i++) {
+        snprintf(labels, sizeof(labels), "canal=\"%s\",limite=\"min\"", config_channel_name(i));
+        metrics_float(w, "station_threshold", labels, cfg.limits[i].min);
+        snprintf(labels, sizeof(labels), "canal=\"%s\",limite=\"max\"", config_channel_name(i));
+        metrics_float(w, "station_threshold", labels, cfg.limits[i].max);
     }
-    else{ // Acende o LED verde, caso contrário
-        gpio_put(LED_GREEN_PIN, true);
-        gpio_put(LED_RED_PIN, false);
+
+    metrics_family(w, "station_alarm_severity", "gauge", "Severidade do alarme: 0 normal, 1 aviso, 2 critico");
+    for (int i = 0; i < 4; i++) {
+        snprintf(labels, sizeof(labels), "canal=\"%s\"", nomes_alarmes[i]);
+        metrics_uint(w, "station_alarm_severity", labels, alarmes[i]->severity);
     }
 }
 
+static void coletar_sistema(metrics_writer_t *w) {
+    metrics_family(w, "station_uptime_seconds", "counter", "Tempo desde o boot");
+    metrics_uint(w, "station_uptime_seconds", NULL, to_ms_since_boot(get_absolute_time()) / 1000);
+    metrics_family(w, "station_i2c_errors_total", "counter", "Leituras dos sensores com falha na I2C");
+    metrics_uint(w, "station_i2c_errors_total", "sensor=\"aht20\"", erros_aht20);
+    metrics_uint(w, "station_i2c_errors_total", "sensor=\"bmp280\"", erros_bmp280);
+    metrics_family(w, "station_wifi_rssi_dbm", "gauge", "Intensidade do sinal Wi-Fi");
+    metrics_float(w, "station_wifi_rssi_dbm", NULL, (float)wifi_rssi);
+    metrics_family(w, "station_boot_first_sample_ms", "gauge", "Tempo do boot ate a primeira amostra publicada");
+    metrics_uint(w, "station_boot_first_sample_ms", NULL, boot_amostra_ms);
+}
+
+static void coletar_perifericos(metrics_writer_t *w) {
+    metrics_family(w, "station_oled_frames_total", "counter", "Quadros enviados ao display");
+    metrics_uint(w, "station_oled_frames_total", NULL, oled_quadros);
+    metrics_family(w, "station_oled_bytes_total", "counter", "Bytes enviados ao display pela I2C");
+    metrics_uint(w, "station_oled_bytes_total", NULL, oled_bytes);
+    metrics_family(w, "station_oled_chars_total", "counter", "Caracteres redesenhados no display");
+    metrics_uint(w, "station_oled_chars_total", NULL, oled_caracteres);
+    metrics_family(w, "station_led_frames_total", "counter", "Quadros da matriz de LEDs");
+    metrics_uint(w, "station_led_frames_total", "resultado=\"enviado\"", matriz.frames_sent);
+    metrics_uint(w, "station_led_frames_total", "resultado=\"repetido\"", matriz.frames_skipped);
+}
+
+static void coletar_laco(metrics_writer_t *w) {
+    metrics_histogram(w, "station_loop_duration_us", "Iteracao do laco principal, sem a espera", &duracao_laco);
+}
+
+static void (*const partes_metricas[])(metrics_writer_t *w) = {
+    coletar_medidas, coletar_limites, coletar_sistema, coletar_perifericos, coletar_laco
+};
+#define NUM_PARTES_METRICAS (sizeof(partes_metricas) / sizeof(partes_metricas[0]))
+
+static void coletar_metricas(metrics_writer_t *w, unsigned part) {
+    partes_metricas[part](w);
+}
+
 
 
 // ======== INTERRUPÇÂO ===========
@@ -327,140 +440,211 @@ void gpio_irq_handler(uint gpio, uint32_t events)
 
         else if (gpio == BUTTON_A) {  
             select_screen =  (select_screen + 1) % 4; // Alterna de 0 a 3
+            events_post(EVENT_BUTTON); // Redesenha já, sem esperar a próxima amostra
         }
     }
 }
 
 
+// Temporizador de amostragem e chegada de caracteres pela USB: só avisam o laço principal
+bool temporizador_amostra(repeating_timer_t *t) {
+    events_post(EVENT_SAMPLE);
+    return true;
+}
+
+void usb_recebido(void *param) {
+    events_post(EVENT_USB);
+}
+
 
 // ============ PROGRAMA PRINCIPAL ==========
 int main()
 {
+    memstats_init(); // Antes de tudo, para pintar a pilha enquanto ela ainda está rasa
     stdio_init_all();
     
     ssd1306_t ssd; // Estrutura do display
     struct bmp280_calib_param params;
     initialize_peripherals(&ssd, &params);
+    uint32_t boot_perifericos_ms = to_ms_since_boot(get_absolute_time());
 
     // Ativação das interrupções
     gpio_set_irq_enabled_with_callback(BUTTON_A, GPIO_IRQ_EDGE_FALL, true, &gpio_irq_handler);  
     gpio_set_irq_enabled_with_callback(BUTTON_B, GPIO_IRQ_EDGE_FALL, true, &gpio_irq_handler); 
 
-    inicializar_webserver(&ssd); // Permite a conexão via WIFI para o webserver
+    config_init(&config, &config_padrao); // Limites gravados na flash, antes de o servidor aceitar alterações
+    metrics_register(coletar_metricas, NUM_PARTES_METRICAS);
+    prof_init();
+    rules_init(&regras);
+    inicializar_webserver(&ssd); // Liga o Wi-Fi e o webserver; a conexão segue em segundo plano
+    uint32_t boot_rede_ms = to_ms_since_boot(get_absolute_time());
 
     // Estrutura para armazenar os dados do sensor
     AHT20_Data data;
     int32_t raw_temp_bmp;
     int32_t raw_press_buffer;
 
-    char str_press[7]; // Buffer para armazenar o valor de pressão atmosférica
-    char str_alt[5];  // Buffer para armazenar o valor de altitude
-    char str_temp[5];  // Buffer para armazenar o valor de temperatura (AHT20)
-    char str_umi[5];  // Buffer para armazenar o valor de umidade
+    ui_t ui; // Telas do display: o layout fixo é desenhado na troca de tela, depois só os campos alterados
+    ui_init(&ui, &ssd);
+    char texto[UI_FIELD_MAX + 1]; // Texto formatado de um campo
+
+    double altitude = 0;
 
-    bool cor = true;
+    sensor_trace_begin_loop(); // Com STATION_TRACE, separa a calibração das leituras do laço
+
+    // A primeira amostra sai já na primeira volta do laço; as seguintes, pelo temporizador
+    events_init();
+    static repeating_timer_t temporizador;
+    add_repeating_timer_ms(-INTERVALO_AMOSTRA_MS, temporizador_amostra, NULL, &temporizador);
+    stdio_set_chars_available_callback(usb_recebido, NULL);
+    events_post(EVENT_SAMPLE);
 
     while (1)
     {
-        // Poll do WiFi
-        cyw43_arch_poll();
-
-        // Leitura do BMP280
-        bmp280_read_raw(I2C_PORT, &raw_temp_bmp, &raw_press_buffer);
-        temperature = (float) (bmp280_convert_temp(raw_temp_bmp, &params)) / 100.0;
-        pressure = (float) bmp280_convert_pressure(raw_press_buffer, raw_temp_bmp, &params) / 1000.0;
-
-        // Cálculo da altitude
-        double altitude = calculate_altitude(pressure * 1000);
-
-        printf("Pressao = %.3f kPa\n", pressure);
-        printf("Temperatura BMP: = %.2f C\n", temperature);
-        printf("Altitude estimada: %.2f m\n", altitude);
-
-        // Leitura do AHT20
-        if (aht20_read(I2C_PORT, &data))
-        {
-            humidity = data.humidity;
-            printf("Temperatura AHT: %.2f C\n", data.temperature);
-            printf("Umidade: %.2f %%\n\n\n", data.humidity);
-        }
-        else
-        {
-            printf("Erro na leitura do AHT10!\n\n\n");
+        // Prazo longo, só por garantia: o temporizador de amostragem acorda antes. Um quadro pendente o encurta
+        absolute_time_t prazo = make_timeout_time_ms(ESPERA_MAX_MS);
+        if (ssd1306_pending(&ssd)) prazo = absolute_time_min(prazo, make_timeout_time_us(ssd1306_frame_wait_us(&ssd)));
+        uint32_t eventos = events_wait(prazo);
+
+        uint32_t inicio_laco = time_us_32();
+        wifi_poll(to_ms_since_boot(get_absolute_time())); // Acompanha a conexão e refaz as tentativas
+
+        if (eventos & EVENT_BIT(EVENT_SAMPLE)) {
+            // Leitura do BMP280
+            bool bmp_ok;
+            PROF_SCOPE(PROF_BMP280) {
+                bmp_ok = bmp280_read_raw(I2C_PORT, &raw_temp_bmp, &raw_press_buffer);
+            }
+            if (bmp_ok) {
+                PROF_SCOPE(PROF_COMPENSACAO) {
+                    temperature = (float) (bmp280_convert_temp(raw_temp_bmp, &params)) / 100.0;
+                    pressure = (float) bmp280_convert_pressure(raw_press_buffer, raw_temp_bmp, &params) / 1000.0;
+                }
+            } else {
+                erros_bmp280++;
+                printf("Erro na leitura do BMP280!\n");
+            }
+
+            // Cálculo da altitude
+            PROF_SCOPE(PROF_ALTITUDE) {
+                altitude = bmp280_altitude(pressure * 1000);
+            }
+
+            PROF_SCOPE(PROF_LOG) {
+                printf("Pressao = %.3f kPa\n", pressure);
+                printf("Temperatura BMP: = %.2f C\n", temperature);
+                printf("Altitude estimada: %.2f m\n", altitude);
+            }
+
+            // Leitura do AHT20
+            bool aht_ok;
+            PROF_SCOPE(PROF_AHT20) {
+                aht_ok = aht20_read(I2C_PORT, &data);
+            }
+            if (aht_ok)
+            {
+                humidity = data.humidity;
+                printf("Temperatura AHT: %.2f C\n", data.temperature);
+                printf("Umidade: %.2f %%\n\n\n", data.humidity);
+            }
+            else
+            {
+                erros_aht20++;
+                printf("Erro na leitura do AHT10!\n\n\n");
+            }
+            sensor_trace_flush(); // Transações I2C desta amostra, com STATION_TRACE
+
+            sample_seq++;
+            PROF_SCOPE(PROF_PUBLICACAO) {
+                webserver_publish_sample(sample_seq, temperature, humidity, pressure); // Publica a amostra para a interface web
+            }
+            if (sample_seq == 1) {
+                boot_amostra_ms = to_ms_since_boot(get_absolute_time());
+                printf("Boot: perifericos em %lu ms, cyw43 em %lu ms, primeira amostra em %lu ms\n",
+                       (unsigned long)boot_perifericos_ms, (unsigned long)boot_rede_ms, (unsigned long)boot_amostra_ms);
+            }
+
+            PROF_SCOPE(PROF_ALARMES) {
+                state_measures(temperature, humidity, pressure); // Indica o estado do sistema pelo LED RGB
+                update_matrix(humidity); // Exibe a porcentagem de umidade na matriz de LEDs
+            }
+
+            config_t cfg;
+            config_get(&config, &cfg);
+            printf("Limites (versao %lu):\n", (unsigned long)cfg.version);
+            for (int i = 0; i < CONFIG_NUM_CHANNELS; i++) {
+                printf("  %s: %.1f a %.1f\n", config_channel_name(i), cfg.limits[i].min, cfg.limits[i].max);
+            }
         }
 
-        // Atualiza os buffers de amostras para os gráficos da interface web
-        temp_buffer[buffer_index] = temperature;
-        hum_buffer[buffer_index] = humidity;
-        press_buffer[buffer_index] = pressure;
+        // Atualiza o conteúdo do display: só os caracteres que mudaram são redesenhados.
+        // O botão troca a tela na hora, sem esperar a próxima amostra
+        if (eventos & (EVENT_BIT(EVENT_SAMPLE) | EVENT_BIT(EVENT_BUTTON) | EVENT_BIT(EVENT_NETWORK))) {
+            PROF_SCOPE(PROF_DISPLAY) {
+                ui_show(&ui, &telas[select_screen]);
+                ui_set_field(&ui, CAMPO_IP, wifi_text());
+                snprintf(texto, sizeof(texto), "%.1fC", temperature);
+                ui_set_field(&ui, CAMPO_TEMP, texto);
+                snprintf(texto, sizeof(texto), "%.1f%%", humidity);
+                ui_set_field(&ui, CAMPO_UMI, texto);
+                snprintf(texto, sizeof(texto), "%.1fkPa", pressure);
+                ui_set_field(&ui, CAMPO_PRESS, texto);
+                snprintf(texto, sizeof(texto), "%.0fkPa", pressure);
+                ui_set_field(&ui, CAMPO_PRESS_RESUMO, texto);
+                snprintf(texto, sizeof(texto), "%.0fm", altitude);
+                ui_set_field(&ui, CAMPO_ALT, texto);
+                if (eventos & EVENT_BIT(EVENT_SAMPLE)) {
+                    ui_sparkline_push(&ui, &grafico_temp, temperature);
+                    ui_sparkline_push(&ui, &grafico_umi, humidity);
+                    ui_sparkline_push(&ui, &grafico_press, pressure);
+                }
+            }
+        }
 
-        buffer_index = (buffer_index + 1) % MAX_BUFFER_SIZE; // Alterna rotativamente os itens do buffer, permitindo salvar 20 amostras por sequência
+        // Atualiza o display (apenas as regiões alteradas) em segundo plano, pela DMA. Se o limite de
+        // quadros ou a DMA impedir o envio, o prazo do próximo events_wait acorda o laço para tentar de novo
+        bool quadro_enviado = false;
+        if (ssd1306_pending(&ssd)) {
+            PROF_SCOPE(PROF_OLED) {
+                quadro_enviado = ssd1306_send_data_async(&ssd);
+            }
+        }
+        if (quadro_enviado) {
+            oled_quadros++;
+            oled_bytes += ssd.tx_bytes;
+            oled_caracteres += ui.chars_drawn;
+            ui.chars_drawn = 0;
+        }
 
-        sprintf(str_press, "%.2fkPa", pressure); // Converte o dado de pressão em string
-        sprintf(str_alt, "%.0fm", altitude);  // Converte o dado de altitude em string
-        sprintf(str_temp, "%.1fC", temperature);  // Converte o dado de temperatura (BMP280) em string
-        sprintf(str_umi, "%.1f%%", humidity);  // Converte o dado de umidade em string
-    
-        state_measures(temperature, humidity, pressure); // Indica o estado do sistema pelo LED RGB
-        update_matrix(humidity); // Exibe a porcentagem de umidade na matriz de LEDs
-
-        //  Atualiza o conteúdo do display
-        ssd1306_fill(&ssd, !cor);                           // Limpa o display
-        ssd1306_rect(&ssd, 3, 3, 122, 60, cor, !cor);       // Desenha um retângulo
-        
-        ssd1306_draw_string(&ssd, "WEA. STATION", 16, 8);
-        ssd1306_draw_string(&ssd, "IP:", 6, 16); 
-        ssd1306_draw_string(&ssd, ip_str, 32, 16);   // Escreve o IP da placa
-        ssd1306_line(&ssd, 3, 26, 123, 26, cor);          
-
-        // Verifica qual a tela a ser exibida
-        switch (select_screen){
-
-            case 1: // Tela de Temperatura
-                ssd1306_draw_string(&ssd, "TEMP:", 24, 32); 
-                ssd1306_draw_string(&ssd, str_temp, 65, 32); 
-                break;
-
-            case 2: // Tela de Umidade
-                ssd1306_draw_string(&ssd, "HUM:", 24, 32); 
-                ssd1306_draw_string(&ssd, str_umi, 57, 32); 
-                break;
-               
-            case 3: // Tela de Pressão Atmosférica
-                ssd1306_draw_string(&ssd, "PRESS:", 8, 32); 
-                ssd1306_draw_string(&ssd, str_press, 60, 32);
-                
-                // Exibe altitude aproximada
-                ssd1306_draw_string(&ssd, "ALT:", 8, 42); 
-                ssd1306_draw_string(&ssd, str_alt, 49, 42); 
-                break;   
-            
-            default: // Tela Geral
-                ssd1306_line(&ssd, 63, 25, 63, 60, cor); // Linha Vertical     
-
-                // Exibição de Temperatura
-                ssd1306_draw_string(&ssd, "TEMP:", 12, 30); 
-                ssd1306_draw_string(&ssd, str_temp, 73, 30); 
-
-                // Exibição de Umidade
-                ssd1306_draw_string(&ssd, "HUM:", 12, 40); 
-                ssd1306_draw_string(&ssd, str_umi, 73, 40); 
-
-                // Exibição de Pressão Atmosférica
-                ssd1306_draw_string(&ssd, "PRESS:", 12, 50); 
-                ssd1306_draw_string(&ssd, str_press, 64, 50); 
-                break;
+        config_save_pending(&config, to_ms_since_boot(get_absolute_time())); // Grava na flash depois que as alterações param
+        update_health(to_ms_since_boot(get_absolute_time()));
+
+        // Comandos pela USB: 'm' mostra o uso de memória, 'b' troca o brilho da matriz, 'p' o tempo das etapas e 'r' zera essas medidas
+        int comando;
+        while ((eventos & EVENT_BIT(EVENT_USB)) && (comando = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+            if (comando == 'm') {
+                static char relatorio[MEMSTATS_TEXT_MAX];
+                cyw43_arch_lwip_begin();
+                memstats_format(relatorio, sizeof(relatorio));
+                cyw43_arch_lwip_end();
+                fputs(relatorio, stdout);
+            } else if (comando == 'b') {
+                uint8_t brilho = (animacao.brightness + 1) % LED_ANIM_BRIGHTNESS_LEVELS;
+                led_anim_set_brightness(&animacao, brilho);
+                printf("Brilho da matriz: %u de %u\n", brilho + 1, LED_ANIM_BRIGHTNESS_LEVELS);
+            }
+#if PROF_ENABLED
+            if (comando == 'p') {
+                static char tabela[PROF_TEXT_MAX];
+                prof_format(tabela, sizeof(tabela));
+                fputs(tabela, stdout);
+            } else if (comando == 'r') {
+                prof_reset();
+            }
+#endif
         }
 
-        ssd1306_send_data(&ssd); // Atualiza o display
-        
-        printf("TempMAX: %.1f\n", temp_max_user);
-        printf("TempMIN: %.1f\n", temp_min_user);
-        printf("HumMAX: %.1f\n", hum_max_user);
-        printf("HumMIN: %.1f\n", hum_min_user);
-        printf("PressMAX: %.1f\n", press_max_user);
-        printf("PressMIN: %.1f\n", press_min_user);
-        sleep_ms(500);
+        metrics_histogram_observe(&duracao_laco, time_us_32() - inicio_laco);
     }
 
     return 0;